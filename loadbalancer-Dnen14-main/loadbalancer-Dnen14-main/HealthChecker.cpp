@@ -0,0 +1,260 @@
+/**
+ * @file HealthChecker.cpp
+ * @brief Implementation of the HealthChecker class for active and passive health checking.
+ *
+ * Passive checks watch every call made through the LoadBalancer: consecutive failures
+ * eject a server immediately, and a latency moving average far above the rest of the
+ * pool marks it as an outlier. Active checks periodically probe every server, readmit
+ * ejected servers whose back-off has expired, and eject servers that stop answering.
+ *
+ * @see HealthChecker
+ * @see WebServer
+ *
+ */
+
+#include "HealthChecker.h"
+#include "utils.h"
+#include <algorithm>
+#include <iostream>
+using std::cout, std::endl;
+
+/** Weight given to the newest latency sample in the moving average. */
+static const double LATENCY_EWMA_ALPHA = 0.2;
+
+/**
+ * @brief Constructs a HealthChecker with default thresholds.
+ *
+ * Probes every 10 cycles, ejects after 3 consecutive failures or at 3x the pool's
+ * mean latency, and backs off from 20 up to 640 cycles.
+ */
+HealthChecker::HealthChecker()
+    : probeInterval(10), failureThreshold(3), latencyFactor(3.0), minSamples(5),
+      baseEjectionTime(20), maxEjectionTime(640), maxEjectionPercent(50.0), verbose(true) {}
+
+/**
+ * @brief Removes a server from rotation.
+ *
+ * The ejection time doubles with every ejection the server has accumulated, up to
+ * maxEjectionTime.
+ *
+ * @param server The server to eject.
+ * @param now The current simulation cycle.
+ * @param reason Short description written to the log.
+ */
+void HealthChecker::eject(WebServer& server, int now, const char* reason){
+    ServerHealth& health = server.get_health();
+    int shift = std::min(health.ejections, 30);
+    long long duration = std::min<long long>((long long) baseEjectionTime << shift, maxEjectionTime);
+    health.ejected = true;
+    health.ejectedUntil = now + (int) duration;
+    health.ejections++;
+    if (verbose) cout << "[WARN] Ejected WebServer on port " << server.get_port() << " (" << reason
+         << ") for " << duration << " cycles." << endl;
+}
+
+/**
+ * @brief Returns a server to rotation.
+ *
+ * Failure and latency history are cleared so the server is judged on fresh samples;
+ * the ejection count is kept so a flapping server keeps backing off.
+ *
+ * @param server The server to readmit.
+ */
+void HealthChecker::readmit(WebServer& server){
+    ServerHealth& health = server.get_health();
+    health.ejected = false;
+    health.consecutiveFailures = 0;
+    health.samples = 0;
+    health.latencyEwma = 0.0;
+    if (verbose) cout << "[INFO] Readmitted WebServer on port " << server.get_port() << " to rotation." << endl;
+}
+
+/**
+ * @brief Records a successful call and its latency.
+ *
+ * @param server The server that handled the call.
+ * @param latency Observed latency, in cycles.
+ */
+void HealthChecker::record_success(WebServer& server, int latency){
+    ServerHealth& health = server.get_health();
+    health.consecutiveFailures = 0;
+    if (health.samples == 0) {
+        health.latencyEwma = latency;
+    } else {
+        health.latencyEwma += LATENCY_EWMA_ALPHA * (latency - health.latencyEwma);
+    }
+    health.samples++;
+}
+
+/**
+ * @brief Records a failed call.
+ *
+ * Ejects the server once its consecutive failures reach the threshold. Failure
+ * ejections are not limited by maxEjectionPercent; if every server ends up ejected
+ * the LoadBalancer falls back to routing across the whole pool.
+ *
+ * @param server The server that failed.
+ * @param now The current simulation cycle.
+ */
+void HealthChecker::record_failure(WebServer& server, int now){
+    ServerHealth& health = server.get_health();
+    health.consecutiveFailures++;
+    if (!health.ejected && health.consecutiveFailures >= failureThreshold) {
+        eject(server, now, "consecutive failures");
+    }
+}
+
+/**
+ * @brief Checks whether a server may currently receive work.
+ *
+ * @param server The server to check.
+ * @return true If the server is in rotation.
+ */
+bool HealthChecker::is_available(WebServer& server) const {
+    return !server.get_health().ejected;
+}
+
+/**
+ * @brief Runs active probes and latency outlier detection.
+ *
+ * Ejected servers whose back-off has expired are probed and either readmitted or
+ * ejected again for longer. Servers in rotation are probed and ejected if they do not
+ * answer; once one has stayed in rotation for maxEjectionTime cycles its back-off is
+ * reset. Finally, servers whose latency average exceeds latencyFactor times the mean
+ * of the other servers are ejected, as long as that keeps the ejected share of the
+ * pool within maxEjectionPercent.
+ *
+ * @param servers The server pool.
+ * @param now The current simulation cycle.
+ */
+void HealthChecker::run_checks(vector<WebServer*>& servers, int now){
+    if (probeInterval <= 0 || now % probeInterval != 0) return;
+
+    int ejectedCount = 0;
+    for (WebServer* server : servers) {
+        ServerHealth& health = server->get_health();
+        if (health.ejected) {
+            if (now < health.ejectedUntil) {
+                ejectedCount++;
+            } else if (server->probe()) {
+                readmit(*server);
+            } else {
+                eject(*server, now, "probe failed");
+                ejectedCount++;
+            }
+        } else if (!server->probe()) {
+            eject(*server, now, "probe failed");
+            ejectedCount++;
+        } else if (health.ejections > 0 && now >= health.ejectedUntil + maxEjectionTime) {
+            health.ejections = 0;
+        }
+    }
+
+    double latencySum = 0.0;
+    int sampled = 0;
+    for (WebServer* server : servers) {
+        ServerHealth& health = server->get_health();
+        if (!health.ejected && health.samples >= minSamples) {
+            latencySum += health.latencyEwma;
+            sampled++;
+        }
+    }
+    if (sampled < 2) return;
+
+    int maxEjected = (int) (servers.size() * maxEjectionPercent / 100.0);
+    for (WebServer* server : servers) {
+        if (ejectedCount >= maxEjected) break;
+        ServerHealth& health = server->get_health();
+        if (health.ejected || health.samples < minSamples) continue;
+        double othersMean = (latencySum - health.latencyEwma) / (sampled - 1);
+        if (health.latencyEwma > latencyFactor * othersMean) {
+            eject(*server, now, "latency outlier");
+            ejectedCount++;
+        }
+    }
+}
+
+/**
+ * @brief Sets how often active probes run.
+ *
+ * @param cycles Probe interval, in cycles.
+ */
+void HealthChecker::set_probe_interval(int cycles){
+    probeInterval = cycles;
+}
+
+/**
+ * @brief Sets the number of consecutive failures that ejects a server.
+ *
+ * @param failures Failure threshold.
+ */
+void HealthChecker::set_failure_threshold(int failures){
+    failureThreshold = failures;
+}
+
+/**
+ * @brief Sets the latency outlier factor.
+ *
+ * @param factor Multiple of the mean latency of the other servers.
+ */
+void HealthChecker::set_latency_factor(double factor){
+    latencyFactor = factor;
+}
+
+/**
+ * @brief Sets the first ejection time and the back-off cap.
+ *
+ * @param base First ejection time, in cycles.
+ * @param max Longest ejection time, in cycles.
+ */
+void HealthChecker::set_ejection_time(int base, int max){
+    baseEjectionTime = base;
+    maxEjectionTime = max;
+}
+
+/**
+ * @brief Sets the largest share of the pool that may be ejected as latency outliers.
+ *
+ * @param percent Percentage of servers, in [0, 100].
+ */
+void HealthChecker::set_max_ejection_percent(double percent){
+    maxEjectionPercent = percent;
+}
+
+/**
+ * @brief Turns logging of ejections and readmissions on or off.
+ *
+ * @param enabled True to log.
+ */
+void HealthChecker::set_verbose(bool enabled){
+    verbose = enabled;
+}
+
+/**
+ * @brief Writes the checker's thresholds to a binary snapshot.
+ *
+ * Per-server health lives in each WebServer and is saved with it.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void HealthChecker::save(std::ostream& out) const {
+    write_value(out, probeInterval);
+    write_value(out, failureThreshold);
+    write_value(out, latencyFactor);
+    write_value(out, minSamples);
+    write_value(out, baseEjectionTime);
+    write_value(out, maxEjectionTime);
+    write_value(out, maxEjectionPercent);
+}
+
+/**
+ * @brief Restores thresholds written by save().
+ *
+ * @param in Stream opened in binary mode.
+ * @return true On success.
+ */
+bool HealthChecker::restore(std::istream& in) {
+    return read_value(in, probeInterval) && read_value(in, failureThreshold) && read_value(in, latencyFactor)
+        && read_value(in, minSamples) && read_value(in, baseEjectionTime) && read_value(in, maxEjectionTime)
+        && read_value(in, maxEjectionPercent);
+}
@@ -0,0 +1,140 @@
+#ifndef HEALTHCHECKER_H
+#define HEALTHCHECKER_H
+#include "Webserver.h"
+#include <vector>
+using std::vector;
+
+/**
+ * @file HealthChecker.h
+ * @brief Defines the HealthChecker class, which ejects unhealthy web servers from rotation.
+ *
+ * The HealthChecker combines active health probes with passive outlier detection.
+ * Servers are ejected after too many consecutive failures or when their latency
+ * drifts far above the rest of the pool, and are readmitted after an exponentially
+ * growing back-off once a probe succeeds again.
+ */
+
+/**
+ * @class HealthChecker
+ * @brief Tracks server health and decides which servers may receive work.
+ *
+ * All decisions are made against the simulation clock passed in by the caller, so
+ * checking availability on the dispatch path is a couple of field reads and never
+ * waits on a probe.
+ */
+class HealthChecker {
+private:
+    int probeInterval;
+    int failureThreshold;
+    double latencyFactor;
+    int minSamples;
+    int baseEjectionTime;
+    int maxEjectionTime;
+    double maxEjectionPercent;
+    bool verbose;
+
+    /**
+     * @brief Removes a server from rotation with exponential back-off.
+     */
+    void eject(WebServer& server, int now, const char* reason);
+
+    /**
+     * @brief Returns a server to rotation and clears its failure history.
+     */
+    void readmit(WebServer& server);
+
+public:
+
+    /**
+     * @brief Constructs a HealthChecker with default thresholds.
+     */
+    HealthChecker();
+
+    /**
+     * @brief Records a successful call and its latency.
+     *
+     * @param server The server that handled the call.
+     * @param latency Observed latency, in cycles.
+     */
+    void record_success(WebServer& server, int latency);
+
+    /**
+     * @brief Records a failed call, ejecting the server once failures reach the threshold.
+     *
+     * @param server The server that failed.
+     * @param now The current simulation cycle.
+     */
+    void record_failure(WebServer& server, int now);
+
+    /**
+     * @brief Checks whether a server may currently receive work.
+     *
+     * @param server The server to check.
+     * @return True if the server is in rotation.
+     */
+    bool is_available(WebServer& server) const;
+
+    /**
+     * @brief Runs active probes and latency outlier detection.
+     *
+     * Only does work every probeInterval cycles, so it is cheap to call every cycle.
+     *
+     * @param servers The server pool.
+     * @param now The current simulation cycle.
+     */
+    void run_checks(vector<WebServer*>& servers, int now);
+
+    /**
+     * @brief Sets how often active probes run.
+     * @param cycles Probe interval, in cycles.
+     */
+    void set_probe_interval(int cycles);
+
+    /**
+     * @brief Sets the number of consecutive failures that ejects a server.
+     * @param failures Failure threshold.
+     */
+    void set_failure_threshold(int failures);
+
+    /**
+     * @brief Sets how far above the pool mean a server's latency may drift before ejection.
+     * @param factor Multiple of the mean latency of the other servers.
+     */
+    void set_latency_factor(double factor);
+
+    /**
+     * @brief Sets the first ejection time and the cap the back-off doubles towards.
+     * @param base First ejection time, in cycles.
+     * @param max Longest ejection time, in cycles.
+     */
+    void set_ejection_time(int base, int max);
+
+    /**
+     * @brief Sets the largest share of the pool that may be ejected as latency outliers.
+     * @param percent Percentage of servers, in [0, 100].
+     */
+    void set_max_ejection_percent(double percent);
+
+    /**
+     * @brief Turns logging of ejections and readmissions on or off.
+     * @param enabled True to log.
+     */
+    void set_verbose(bool enabled);
+
+    /**
+     * @brief Writes the checker's thresholds to a binary snapshot.
+     *
+     * @param out Stream opened in binary mode.
+     */
+    void save(std::ostream& out) const;
+
+    /**
+     * @brief Restores thresholds written by save().
+     *
+     * @param in Stream opened in binary mode.
+     * @return True on success.
+     */
+    bool restore(std::istream& in);
+};
+
+#endif
@@ -0,0 +1,241 @@
+/**
+ * @file HierarchicalBalancer.cpp
+ * @brief Implementation of the HierarchicalBalancer class.
+ *
+ * @see HierarchicalBalancer
+ *
+ */
+
+#include "HierarchicalBalancer.h"
+#include "Random.h"
+#include <algorithm>
+
+/**
+ * @brief Constructs the dispatcher and its racks.
+ *
+ * Every cached signal starts out expired, so the first decision pulls them all.
+ *
+ * @param rackCount Number of rack-local LoadBalancers.
+ * @param maxServers Maximum servers per rack.
+ * @param maxStaleness Oldest signal age, in cycles, routing may use; 0 refreshes on every decision.
+ */
+HierarchicalBalancer::HierarchicalBalancer(int rackCount, int maxServers, int maxStaleness)
+    : maxStaleness(maxStaleness), nextRack(0), signalUpdates(0), count(0) {
+    if (rackCount < 1) rackCount = 1;
+    for (int i = 0; i < rackCount; ++i) {
+        racks.push_back(std::make_unique<LoadBalancer>(0, 8080 + i * maxServers, maxServers));
+        racks.back()->set_verbose(false);
+    }
+    LoadSignal expired;
+    expired.cycle = -maxStaleness - 1;
+    signals.assign(rackCount, expired);
+    routedSince.assign(rackCount, 0);
+}
+
+/**
+ * @brief Pulls a rack's signal if it is older than the staleness bound.
+ *
+ * With a bound of 0 the signal is pulled for every decision, even within a cycle,
+ * since requests routed earlier in the cycle have already changed it.
+ *
+ * @param rack The rack index.
+ */
+void HierarchicalBalancer::refresh_signal(int rack) {
+    if (maxStaleness > 0 && count - signals[rack].cycle < maxStaleness) return;
+    signals[rack] = racks[rack]->get_load_signal();
+    routedSince[rack] = 0;
+    signalUpdates++;
+}
+
+/**
+ * @brief Picks the rack for a request from the cached load signals.
+ *
+ * @param request The request to route.
+ * @return int The rack index.
+ */
+int HierarchicalBalancer::route(const Request&) {
+    int size = racks.size();
+    int best = nextRack;
+    double bestWait = 0.0;
+    for (int i = 0; i < size; ++i) {
+        int rack = (nextRack + i) % size;
+        refresh_signal(rack);
+        const LoadSignal& signal = signals[rack];
+        double wait = (signal.queueSize + routedSince[rack] + 1.0) / std::max(1, signal.servers);
+        if (i == 0 || wait < bestWait) {
+            best = rack;
+            bestWait = wait;
+        }
+    }
+    nextRack = (nextRack + 1) % size;
+    return best;
+}
+
+/**
+ * @brief Routes a request and adds it to the chosen rack's queue.
+ *
+ * @param request The request to add.
+ */
+void HierarchicalBalancer::add_request(const Request& request) {
+    int rack = route(request);
+    racks[rack]->add_request(request);
+    routedSince[rack]++;
+}
+
+/**
+ * @brief Runs one cycle on every rack.
+ */
+void HierarchicalBalancer::distribute_requests() {
+    for (std::unique_ptr<LoadBalancer>& rack : racks) {
+        rack->distribute_requests();
+    }
+    count++;
+}
+
+/**
+ * @brief Publishes every rack's metrics, labelled rack="i".
+ *
+ * @param registry The registry to register metrics in.
+ */
+void HierarchicalBalancer::enable_metrics(MetricsRegistry& registry) {
+    for (size_t i = 0; i < racks.size(); ++i) {
+        racks[i]->enable_metrics(registry, "rack=\"" + std::to_string(i) + "\"");
+    }
+}
+
+/**
+ * @brief Seeds every rack from one master seed.
+ *
+ * Rack i is seeded from stream 16 + i, like the shards of a ShardedBalancer.
+ *
+ * @param seed Any 64-bit value.
+ */
+void HierarchicalBalancer::seed(uint64_t seed) {
+    for (size_t i = 0; i < racks.size(); ++i) {
+        racks[i]->seed(derive_seed(seed, 16 + i));
+    }
+}
+
+/**
+ * @brief Turns per-cycle console logging on or off for every rack.
+ *
+ * @param enabled True to log.
+ */
+void HierarchicalBalancer::set_verbose(bool enabled) {
+    for (std::unique_ptr<LoadBalancer>& rack : racks) {
+        rack->set_verbose(enabled);
+    }
+}
+
+/**
+ * @brief Sets the simulated processing delay of every rack.
+ *
+ * @param milliseconds Upper bound of the wall-clock delay; 0 disables it.
+ */
+void HierarchicalBalancer::set_max_processing_delay(int milliseconds) {
+    for (std::unique_ptr<LoadBalancer>& rack : racks) {
+        rack->set_max_processing_delay(milliseconds);
+    }
+}
+
+/**
+ * @brief Gets the number of racks.
+ *
+ * @return int Rack count.
+ */
+int HierarchicalBalancer::get_rack_count() const {
+    return racks.size();
+}
+
+/**
+ * @brief Gets one rack's LoadBalancer.
+ *
+ * @param index The rack index.
+ * @return LoadBalancer& The rack's LoadBalancer.
+ */
+LoadBalancer& HierarchicalBalancer::get_rack(int index) {
+    return *racks[index];
+}
+
+/**
+ * @brief Gets the number of load signals pulled from the racks so far.
+ *
+ * @return long long Coordination message count.
+ */
+long long HierarchicalBalancer::get_signal_updates() const {
+    return signalUpdates;
+}
+
+/**
+ * @brief Gets the total number of queued requests across racks.
+ *
+ * @return int Queue size.
+ */
+int HierarchicalBalancer::get_queue_size() {
+    int total = 0;
+    for (std::unique_ptr<LoadBalancer>& rack : racks) {
+        total += rack->get_queue_size();
+    }
+    return total;
+}
+
+/**
+ * @brief Gets the number of requests completed across racks.
+ *
+ * @return long long Completed request count.
+ */
+long long HierarchicalBalancer::get_completed_requests() const {
+    long long total = 0;
+    for (const std::unique_ptr<LoadBalancer>& rack : racks) {
+        total += rack->get_completed_requests();
+    }
+    return total;
+}
+
+/**
+ * @brief Gets the server-cycles spent across racks.
+ *
+ * @return long long Server-cycles.
+ */
+long long HierarchicalBalancer::get_server_cycles() const {
+    long long total = 0;
+    for (const std::unique_ptr<LoadBalancer>& rack : racks) {
+        total += rack->get_server_cycles();
+    }
+    return total;
+}
+
+/**
+ * @brief Gets the price of the servers provisioned across racks.
+ *
+ * @return double Server cost.
+ */
+double HierarchicalBalancer::get_server_cost() const {
+    double total = 0.0;
+    for (const std::unique_ptr<LoadBalancer>& rack : racks) {
+        total += rack->get_server_cost();
+    }
+    return total;
+}
+
+/**
+ * @brief Merges the latency histograms of every rack.
+ *
+ * @return LatencyHistogram The latency histogram of the whole hierarchy.
+ */
+LatencyHistogram HierarchicalBalancer::get_latency_histogram() const {
+    LatencyHistogram merged;
+    for (const std::unique_ptr<LoadBalancer>& rack : racks) {
+        merged.merge(rack->get_latency_histogram());
+    }
+    return merged;
+}
+
+/**
+ * @brief Gets the number of cycles the dispatcher has run.
+ *
+ * @return int The current simulation cycle.
+ */
+int HierarchicalBalancer::get_cycle() const {
+    return count;
+}
@@ -0,0 +1,174 @@
+#ifndef HIERARCHICALBALANCER_H
+#define HIERARCHICALBALANCER_H
+#include "LoadBalancer.h"
+#include "LatencyHistogram.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @file HierarchicalBalancer.h
+ * @brief Defines the HierarchicalBalancer class, a global dispatcher in front of rack-local LoadBalancers.
+ *
+ * The dispatcher treats each child LoadBalancer as a single backend and routes on
+ * the LoadSignal it publishes. Signals are pulled lazily: a rack's cached signal is
+ * only refreshed when a routing decision needs it and it is older than the
+ * staleness bound. Every refresh is counted as one coordination message, so a run
+ * shows both sides of the trade-off: fresher signals cost more messages, staler
+ * signals cost latency through worse placement.
+ *
+ * @see LoadBalancer
+ * @see LoadSignal
+ */
+
+/**
+ * @class HierarchicalBalancer
+ * @brief Two-level balancing: a global dispatcher over per-rack LoadBalancers.
+ *
+ * A request goes to the rack with the lowest expected wait per server,
+ * (queueSize + 1) / servers, as last reported. Requests sent to a rack since its
+ * last report are added to that report, so a stale signal does not send every
+ * request to the same rack until the next refresh. Ties are broken in rotation.
+ */
+class HierarchicalBalancer {
+private:
+    std::vector<std::unique_ptr<LoadBalancer>> racks;
+    std::vector<LoadSignal> signals;
+    std::vector<int> routedSince;
+    int maxStaleness;
+    int nextRack;
+    long long signalUpdates;
+    int count;
+
+    /**
+     * @brief Pulls a rack's signal if it is older than the staleness bound.
+     */
+    void refresh_signal(int rack);
+
+public:
+
+    /**
+     * @brief Constructs the dispatcher and its racks.
+     *
+     * Racks start silent with no servers and scale up to maxServers each.
+     *
+     * @param rackCount Number of rack-local LoadBalancers.
+     * @param maxServers Maximum servers per rack.
+     * @param maxStaleness Oldest signal age, in cycles, routing may use; 0 refreshes on every decision.
+     */
+    HierarchicalBalancer(int rackCount, int maxServers, int maxStaleness);
+
+    /**
+     * @brief Picks the rack for a request from the cached load signals.
+     *
+     * @param request The request to route.
+     * @return The rack index.
+     */
+    int route(const Request& request);
+
+    /**
+     * @brief Routes a request and adds it to the chosen rack's queue.
+     *
+     * @param request The request to add.
+     */
+    void add_request(const Request& request);
+
+    /**
+     * @brief Runs one cycle on every rack.
+     */
+    void distribute_requests();
+
+    /**
+     * @brief Publishes every rack's metrics, labelled rack="i".
+     *
+     * @param registry The registry to register metrics in; must outlive the dispatcher.
+     */
+    void enable_metrics(MetricsRegistry& registry);
+
+    /**
+     * @brief Seeds every rack from one master seed.
+     *
+     * @param seed Any 64-bit value.
+     */
+    void seed(uint64_t seed);
+
+    /**
+     * @brief Turns per-cycle console logging on or off for every rack.
+     *
+     * @param enabled True to log.
+     */
+    void set_verbose(bool enabled);
+
+    /**
+     * @brief Sets the simulated processing delay of every rack.
+     *
+     * @param milliseconds Upper bound of the wall-clock delay; 0 disables it.
+     */
+    void set_max_processing_delay(int milliseconds);
+
+    /**
+     * @brief Gets the number of racks.
+     *
+     * @return Rack count.
+     */
+    int get_rack_count() const;
+
+    /**
+     * @brief Gets one rack's LoadBalancer for configuration or inspection.
+     *
+     * @param index The rack index.
+     * @return The rack's LoadBalancer.
+     */
+    LoadBalancer& get_rack(int index);
+
+    /**
+     * @brief Gets the number of load signals pulled from the racks so far.
+     *
+     * @return Coordination message count.
+     */
+    long long get_signal_updates() const;
+
+    /**
+     * @brief Gets the total number of queued requests across racks.
+     *
+     * @return Queue size.
+     */
+    int get_queue_size();
+
+    /**
+     * @brief Gets the number of requests completed across racks.
+     *
+     * @return Completed request count.
+     */
+    long long get_completed_requests() const;
+
+    /**
+     * @brief Gets the server-cycles spent across racks.
+     *
+     * @return Server-cycles.
+     */
+    long long get_server_cycles() const;
+
+    /**
+     * @brief Gets the price of the servers provisioned across racks.
+     *
+     * @return Server cost.
+     */
+    double get_server_cost() const;
+
+    /**
+     * @brief Merges the latency histograms of every rack.
+     *
+     * @return The latency histogram of the whole hierarchy.
+     */
+    LatencyHistogram get_latency_histogram() const;
+
+    /**
+     * @brief Gets the number of cycles the dispatcher has run.
+     *
+     * @return The current simulation cycle.
+     */
+    int get_cycle() const;
+};
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ * @file LatencyHistogram.cpp
+ * @brief Implementation of the LatencyHistogram class.
+ *
+ * @see LatencyHistogram
+ *
+ */
+
+#include "LatencyHistogram.h"
+#include "utils.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+/** Number of power-of-two buckets above EXACT_LIMIT (covers every positive int). */
+static const int LOG_BUCKETS = 22;
+
+/**
+ * @brief Constructs an empty histogram.
+ */
+LatencyHistogram::LatencyHistogram()
+    : buckets(EXACT_LIMIT + LOG_BUCKETS, 0), total(0), sum(0), maxValue(0) {}
+
+/**
+ * @brief Maps a latency to its bucket.
+ *
+ * @param value Latency in cycles, non-negative.
+ * @return int Bucket index.
+ */
+int LatencyHistogram::bucket_for(int value) {
+    if (value < EXACT_LIMIT) return value;
+    int bucket = EXACT_LIMIT;
+    int bound = EXACT_LIMIT * 2;
+    while (value >= bound && bucket < EXACT_LIMIT + LOG_BUCKETS - 1) {
+        bucket++;
+        bound = bound > INT_MAX / 2 ? INT_MAX : bound * 2;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Gets the largest latency that falls into a bucket.
+ *
+ * @param bucket Bucket index.
+ * @return int The bucket's upper bound.
+ */
+int LatencyHistogram::bucket_upper_bound(int bucket) {
+    if (bucket < EXACT_LIMIT) return bucket;
+    long long bound = (long long) EXACT_LIMIT << (bucket - EXACT_LIMIT + 1);
+    return (int) std::min<long long>(bound - 1, INT_MAX);
+}
+
+/**
+ * @brief Records one latency.
+ *
+ * @param cycles Latency in cycles.
+ */
+void LatencyHistogram::record(int cycles) {
+    if (cycles < 0) cycles = 0;
+    buckets[bucket_for(cycles)]++;
+    total++;
+    sum += cycles;
+    maxValue = std::max(maxValue, cycles);
+}
+
+/**
+ * @brief Gets a percentile of the recorded latencies.
+ *
+ * @param percent Percentile in [0, 100].
+ * @return int The latency at that percentile, or 0 if nothing was recorded.
+ */
+int LatencyHistogram::percentile(double percent) const {
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t) std::ceil(percent / 100.0 * total);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return std::min(bucket_upper_bound(i), maxValue);
+    }
+    return maxValue;
+}
+
+/**
+ * @brief Gets the mean recorded latency.
+ *
+ * @return double The mean, or 0 if nothing was recorded.
+ */
+double LatencyHistogram::mean() const {
+    return total == 0 ? 0.0 : (double) sum / total;
+}
+
+/**
+ * @brief Gets the largest recorded latency.
+ *
+ * @return int The maximum.
+ */
+int LatencyHistogram::max() const {
+    return maxValue;
+}
+
+/**
+ * @brief Gets the number of recorded latencies.
+ *
+ * @return uint64_t The sample count.
+ */
+uint64_t LatencyHistogram::count() const {
+    return total;
+}
+
+/**
+ * @brief Adds every sample of another histogram to this one.
+ *
+ * @param other The histogram to merge in.
+ */
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    maxValue = std::max(maxValue, other.maxValue);
+}
+
+/**
+ * @brief Writes the histogram to a binary snapshot.
+ *
+ * Only non-empty buckets are written, as (index, count) pairs.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void LatencyHistogram::save(std::ostream& out) const {
+    write_value(out, total);
+    write_value(out, sum);
+    write_value(out, maxValue);
+    uint32_t used = std::count_if(buckets.begin(), buckets.end(), [](uint64_t c) { return c != 0; });
+    write_value(out, used);
+    for (uint32_t i = 0; i < buckets.size(); ++i) {
+        if (buckets[i] == 0) continue;
+        write_value(out, i);
+        write_value(out, buckets[i]);
+    }
+}
+
+/**
+ * @brief Restores a histogram written by save().
+ *
+ * @param in Stream opened in binary mode.
+ * @return true On success.
+ */
+bool LatencyHistogram::restore(std::istream& in) {
+    uint32_t used = 0;
+    if (!read_value(in, total) || !read_value(in, sum) || !read_value(in, maxValue) || !read_value(in, used)) {
+        return false;
+    }
+    std::fill(buckets.begin(), buckets.end(), 0);
+    for (uint32_t n = 0; n < used; ++n) {
+        uint32_t index = 0;
+        uint64_t bucketCount = 0;
+        if (!read_value(in, index) || !read_value(in, bucketCount) || index >= buckets.size()) return false;
+        buckets[index] = bucketCount;
+    }
+    return true;
+}
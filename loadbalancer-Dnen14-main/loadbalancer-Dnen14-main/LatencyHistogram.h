@@ -0,0 +1,105 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/**
+ * @file LatencyHistogram.h
+ * @brief Defines the LatencyHistogram class, a fixed-size histogram of request latencies.
+ *
+ * Latencies up to EXACT_LIMIT cycles are counted exactly; larger ones fall into
+ * power-of-two buckets. Memory use is therefore constant however many requests
+ * are recorded, while percentiles stay exact for typical latencies.
+ */
+
+/**
+ * @class LatencyHistogram
+ * @brief Records latencies in cycles and answers percentile queries.
+ */
+class LatencyHistogram {
+private:
+    static const int EXACT_LIMIT = 1024;
+
+    std::vector<uint64_t> buckets;
+    uint64_t total;
+    long long sum;
+    int maxValue;
+
+    /**
+     * @brief Maps a latency to its bucket.
+     */
+    static int bucket_for(int value);
+
+    /**
+     * @brief Gets the largest latency that falls into a bucket.
+     */
+    static int bucket_upper_bound(int bucket);
+
+public:
+
+    /**
+     * @brief Constructs an empty histogram.
+     */
+    LatencyHistogram();
+
+    /**
+     * @brief Records one latency.
+     *
+     * @param cycles Latency in cycles; negative values are recorded as 0.
+     */
+    void record(int cycles);
+
+    /**
+     * @brief Gets a percentile of the recorded latencies.
+     *
+     * Above EXACT_LIMIT the upper bound of the containing bucket is returned.
+     *
+     * @param percent Percentile in [0, 100], e.g. 99.
+     * @return The latency at that percentile, or 0 if nothing was recorded.
+     */
+    int percentile(double percent) const;
+
+    /**
+     * @brief Gets the mean recorded latency.
+     * @return The mean, or 0 if nothing was recorded.
+     */
+    double mean() const;
+
+    /**
+     * @brief Gets the largest recorded latency.
+     * @return The maximum, or 0 if nothing was recorded.
+     */
+    int max() const;
+
+    /**
+     * @brief Gets the number of recorded latencies.
+     * @return The sample count.
+     */
+    uint64_t count() const;
+
+    /**
+     * @brief Adds every sample of another histogram to this one.
+     *
+     * @param other The histogram to merge in.
+     */
+    void merge(const LatencyHistogram& other);
+
+    /**
+     * @brief Writes the histogram to a binary snapshot.
+     *
+     * @param out Stream opened in binary mode.
+     */
+    void save(std::ostream& out) const;
+
+    /**
+     * @brief Restores a histogram written by save().
+     *
+     * @param in Stream opened in binary mode.
+     * @return True on success.
+     */
+    bool restore(std::istream& in);
+};
+
+#endif
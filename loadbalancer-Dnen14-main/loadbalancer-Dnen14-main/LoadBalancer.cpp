@@ -25,15 +25,27 @@
  * - Dynamic server management based on request load.
  * - Round-robin request distribution to available servers.
  * - Monitoring and logging of active servers and remaining requests.
+ * - Optional health checking that keeps failing and slow servers out of rotation.
+ * - Optional response cache for GET requests and header-based sticky sessions.
+ * - Servers of mixed instance types, each serving several requests at once at its
+ *   own speed, with an optional speed-aware dispatch policy.
  * 
  * @note The LoadBalancer expects a minimum of one server and can handle multiple 
  * requests concurrently based on the configuration.
  */
 #include "LoadBalancer.h"
 #include "RequestQueue.h"
+#include "Tracing.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 using std::cout, std::endl;
 
+/** Fewest bytes save() writes per instance type: an empty name and the numeric fields. */
+static const size_t INSTANCE_TYPE_MIN_BYTES =
+    sizeof(uint32_t) + sizeof(double) + sizeof(int) + sizeof(long long) + sizeof(double);
+
 
 /**
  * @brief Constructs a LoadBalancer with a specified number of initial servers.
@@ -43,9 +55,15 @@ using std::cout, std::endl;
  * @param maxServers Maximum allowable number of servers.
  */
 LoadBalancer::LoadBalancer(int initialServers, int portBase, int maxServers)
-    : currentServer(0), maxServers(maxServers) {
+    : currentServer(0), numServers(initialServers), maxServers(maxServers), healthChecking(false), verbose(true),
+      scaleUpFactor(5), scaleDownFactor(2), completedRequests(0), serverCycles(0),
+      requestTimeout(0), expiredRequests(0), cancelledRequests(0), wastedCycles(0), serverCost(0.0),
+      provisionedCost(0.0), dispatchPolicy(DispatchPolicy::ROUND_ROBIN), drainingServers(0), drainTimeout(-1),
+      drainedServers(0), handedOffRequests(0), batchSize(1) {
     for (int i = 0; i < initialServers; ++i) {
         servers.push_back(new WebServer(portBase + i));
+        sessionSlots.push_back(i);
+        provisionedCost += servers.back()->get_type().cost;
     }
     activeServers = 0;
     count = 0;
@@ -54,46 +72,170 @@ LoadBalancer::LoadBalancer(int initialServers, int portBase, int maxServers)
 /**
  * @brief Destructor for the LoadBalancer class.
  *
- * Cleans up any resources associated with the LoadBalancer.
+ * Deletes every WebServer still owned by the LoadBalancer and withdraws its share
+ * of any shared gauges.
  */
 LoadBalancer::~LoadBalancer() {
+    if (metrics) {
+        metrics->queueSize->add(-metrics->reportedQueue);
+        metrics->servers->add(-metrics->reportedServers);
+    }
+    for (WebServer* server : servers) {
+        delete server;
+    }
 }
 
 /**
  * @brief Adds a request to the queue.
  *
+ * When the response cache is enabled, GET requests with a live cached response are
+ * answered immediately and never reach the queue.
+ *
  * @param request The request to be added to the queue.
  */
 void LoadBalancer::add_request(const Request& request) {
-    requestQueue.add_request(request);
+    TraceSpan span("LoadBalancer::add_request", count);
+    if (metrics) metrics->requests->inc();
+    if (cache && ResponseCache::is_cacheable(request) && cache->lookup(request, count)) {
+        if (metrics) metrics->cacheHits->inc();
+        if (verbose) cout << "[INFO] Served " << request.get_url() << " from cache." << endl;
+        return;
+    }
+    if (requestTimeout > 0 && request.get_deadline() < 0) {
+        Request timed = request;
+        timed.set_deadline(count + requestTimeout);
+        requestQueue.add_request(timed).set_arrival_cycle(count);
+    } else {
+        requestQueue.add_request(request).set_arrival_cycle(count);
+    }
 }
 
 /**
  * @brief Distributes requests among the available servers.
  *
- * Processes requests in the queue by delegating them to available web servers.
- * Increments the request processing count and logs the status to the console.
+ * Increments the cycle count, makes one scaling decision, starts a batch of
+ * requests from the front of the queue on servers with room for them, and serves
+ * one cycle of every request in flight; each
+ * server works on all of its in-flight requests at its own speed. When health
+ * checking is enabled, ejected servers get no new requests and every call's
+ * outcome is reported to the HealthChecker; a failed call hands the request back
+ * to the queue so it is retried, possibly elsewhere. Requests whose deadline has
+ * passed are dropped before a server is chosen, so no cycles go to clients that
+ * have already given up.
  */
 void LoadBalancer::distribute_requests() {
-   if (requestQueue.is_empty()) return;
+    TraceSpan span("LoadBalancer::distribute_requests", count);
+    count++;
+    serverCycles += servers.size();
+    serverCost += provisionedCost;
+    if (metrics) {
+        metrics->cycles->inc();
+        publish_gauges();
+    }
+    if (healthChecking) healthChecker.run_checks(servers, count);
+    drop_expired();
+    if (!requestQueue.is_empty()) {
+        adjust_servers();
+        dispatch_batch();
+    }
+    for (WebServer* server : servers) {
+        serve_requests(*server);
+    }
+    if (drainingServers > 0) release_drained();
+}
+
+/**
+ * @brief Takes a batch of requests from the front of the queue and starts each on the server chosen for it.
+ *
+ * The batch is capped by the free slots in the pool, so requests are only taken
+ * from the queue when they can start. Each request then goes through
+ * select_server() in queue order; one whose server has no room (a full sticky
+ * target, a memory limit, or a faster server worth waiting for) does not hold up
+ * the rest, and is returned to the front of the queue with the other leftovers in
+ * their original order. A request too large for the memory of any instance type
+ * would wait at the front for ever, so it is dropped and counted as expired.
+ */
+void LoadBalancer::dispatch_batch() {
+    TraceSpan span("LoadBalancer::dispatch_batch");
+    int freeSlots = 0;
+    for (const WebServer* server : servers) freeSlots += server->get_free_slots();
+    if (requestQueue.take_requests(std::min(batchSize, freeSlots), batch) == 0) return;
+
+    size_t waiting = 0;
+    for (Request& request : batch) {
+        int index = select_server(request);
+        if (index < 0) {
+            if (!fits_any_server(request)) {
+                expiredRequests++;
+                if (metrics) metrics->expired->inc();
+                if (verbose) cout << "[WARN] Dropped " << request.get_url() << ": larger than the memory of every server." << endl;
+                continue;
+            }
+            if (&batch[waiting] != &request) batch[waiting] = std::move(request);
+            waiting++;
+            continue;
+        }
+        WebServer* server = servers[index];
+        if (verbose) cout << "[INFO] Dispatched " << request.get_url() << " to server port " << server->get_port() << endl;
+        server->assign(std::move(request));
+    }
+    for (size_t i = waiting; i-- > 0;) {
+        requestQueue.requeue_request(batch[i]);
+    }
+}
 
-    adjust_servers();
-    WebServer* server = servers[currentServer];
-    server->start();
+/**
+ * @brief Serves one cycle of every request in flight on a server.
+ *
+ * @param server The server to run.
+ */
+void LoadBalancer::serve_requests(WebServer& server) {
+    std::vector<Request>& requests = server.get_requests();
+    if (requests.empty()) return;
+    server.start();
+    for (size_t i = 0; i < requests.size();) {
+        Request& request = requests[i];
+        if (request.is_expired(count)) {
+            record_expired(request);
+            requests.erase(requests.begin() + i);
+            continue;
+        }
 
-    Request& request = requestQueue.get_front_request();
-    request.decrement_task_time();
+        int latency = 0;
+        if (!server.serve(latency, rng)) {
+            if (verbose) cout << "[WARN] Request failed on server port " << server.get_port() << endl;
+            if (healthChecking) healthChecker.record_failure(server, count);
+            if (metrics) metrics->failures->inc();
+            requestQueue.requeue_request(request);
+            requests.erase(requests.begin() + i);
+            continue;
+        }
+        if (healthChecking) healthChecker.record_success(server, latency);
+        request.do_work(server.get_effective_speed());
 
-    cout << "[INFO] Processing request on server port " << server->get_port()
-              << " (Remaining task time: " << request.get_task_time() << " cycles)" << endl;
+        if (verbose) {
+            cout << "[INFO] Processing request on server port " << server.get_port()
+                      << " (Remaining task time: " << request.get_task_time() << " cycles)" << endl;
+        }
 
-    if (request.is_completed()) {
-        cout << "[INFO] Request completed and removed from the queue." << endl;
-        requestQueue.process_next_request();
+        if (request.is_completed()) {
+            if (verbose) cout << "[INFO] Request completed and removed from the server." << endl;
+            if (cache && ResponseCache::is_cacheable(request)) cache->insert(request, count);
+            completedRequests++;
+            latencies.record(count - request.get_arrival_cycle());
+            bool scaledDown = request.is_drained();
+            if (scaledDown) drainLatencies.record(count - request.get_arrival_cycle());
+            if (metrics) {
+                metrics->completed->inc();
+                metrics->latency->observe(count - request.get_arrival_cycle());
+                if (scaledDown) metrics->drainLatency->observe(count - request.get_arrival_cycle());
+            }
+            requests.erase(requests.begin() + i);
+            continue;
+        }
+        ++i;
     }
-
-    server->stop();
-    currentServer = (currentServer + 1) % servers.size();
+    server.stop();
 }
 
 /**
@@ -126,47 +268,757 @@ void LoadBalancer::print_remaining_requests() {
 /**
  * @brief Adds a new server to the LoadBalancer.
  *
- * If the maximum number of servers has not been reached, a new server is created and added.
+ * Cancelling a drain is cheaper than provisioning, so a draining server is put
+ * back in rotation if there is one; its requests no longer count as caught by a
+ * scale-down. Otherwise the new server gets the configured
+ * type with the fewest serving servers, or the standard type if no mix is set.
  */
 void LoadBalancer::add_server() {
+    for (WebServer* server : servers) {
+        if (!server->is_draining()) continue;
+        server->stop_draining();
+        for (Request& request : server->get_requests()) request.set_drained(false);
+        drainingServers--;
+        activeServers++;
+        if (verbose) cout << "[INFO] Returned draining WebServer on port " << server->get_port() << " to rotation." << endl;
+        return;
+    }
+    if (instanceTypes.empty()) {
+        add_server(InstanceType());
+        return;
+    }
+    const InstanceType* chosen = &instanceTypes.front();
+    int fewest = -1;
+    for (const InstanceType& type : instanceTypes) {
+        int serving = 0;
+        for (const WebServer* server : servers) {
+            if (!server->is_draining() && server->get_type().name == type.name) serving++;
+        }
+        if (fewest < 0 || serving < fewest) {
+            chosen = &type;
+            fewest = serving;
+        }
+    }
+    add_server(*chosen);
+}
+
+/**
+ * @brief Adds a new server of a given instance type.
+ *
+ * If the maximum number of servers has not been reached, a new server is created
+ * and added. It takes over the first session slot left by a released server, so
+ * only the sessions forwarded from that slot move back; otherwise it gets a new
+ * slot at the end.
+ *
+ * @param type The capacity and price of the new server.
+ */
+void LoadBalancer::add_server(const InstanceType& type) {
+    TraceSpan span("LoadBalancer::add_server");
     if ((int) servers.size() < maxServers) {
-        int port = 8080 + servers.size();
-        servers.push_back(new WebServer(port));
+        int port = 8080;
+        for (WebServer* server : servers) port = std::max(port, server->get_port() + 1);
+        servers.push_back(new WebServer(port, type));
+        auto hole = std::find(sessionSlots.begin(), sessionSlots.end(), -1);
+        if (hole != sessionSlots.end()) {
+            *hole = servers.size() - 1;
+        } else {
+            sessionSlots.push_back(servers.size() - 1);
+        }
+        provisionedCost += type.cost;
         activeServers++;
-        cout << "[INFO] Added a new WebServer on port " << port << ". Total servers: " << servers.size() << endl;
+        if (verbose) cout << "[INFO] Added a new " << type.name << " WebServer on port " << port << ". Total servers: " << servers.size() << endl;
     }
 }
 
 /**
  * @brief Removes a server from the LoadBalancer.
  *
- * If more than one server is active, the last server is removed,
- * and the current server index is adjusted accordingly.
+ * If more than one server is serving, the one with the least remaining work, the
+ * newest on a tie, starts draining. It gets no new requests and is released by
+ * release_drained() once its in-flight requests have finished or been handed off;
+ * an idle server is released at once.
  */
 void LoadBalancer::remove_server() {
-    if (servers.size() > 1) {
-        WebServer* server = servers.back();
+    TraceSpan span("LoadBalancer::remove_server");
+    if ((int) servers.size() - drainingServers > 1) {
+        WebServer* victim = nullptr;
+        double least = 0.0;
+        for (auto server = servers.rbegin(); server != servers.rend(); ++server) {
+            if ((*server)->is_draining()) continue;
+            double work = (*server)->get_remaining_work();
+            if (!victim || work < least) {
+                victim = *server;
+                least = work;
+            }
+        }
+        victim->start_draining(count);
+        for (Request& request : victim->get_requests()) request.set_drained(true);
+        drainingServers++;
+        activeServers--;
+        if (verbose && victim->get_in_flight() > 0) {
+            cout << "[INFO] Draining WebServer on port " << victim->get_port() << " with "
+                 << victim->get_in_flight() << " requests in flight." << endl;
+        }
+        release_drained();
+    }
+}
+
+/**
+ * @brief Releases draining servers that have finished or handed off their in-flight requests.
+ *
+ * A draining server still busy after the drain timeout hands its requests back to
+ * the front of the queue, keeping the work already done on them, and is released.
+ * The round-robin position is adjusted so it keeps pointing at the same server.
+ * The released server's session slot is left empty rather than closed up, so the
+ * sessions of every other server keep their server; trailing empty slots are
+ * dropped, which only moves sessions that were already being forwarded.
+ */
+void LoadBalancer::release_drained() {
+    for (int index = servers.size() - 1; index >= 0; --index) {
+        WebServer* server = servers[index];
+        if (!server->is_draining()) continue;
+        std::vector<Request>& requests = server->get_requests();
+        if (!requests.empty()) {
+            if (drainTimeout < 0 || count - server->get_draining_since() < drainTimeout) continue;
+            for (auto request = requests.rbegin(); request != requests.rend(); ++request) {
+                requestQueue.requeue_request(*request);
+            }
+            handedOffRequests += requests.size();
+            if (metrics) metrics->handoffs->inc(requests.size());
+            if (verbose) cout << "[INFO] Handed off " << requests.size() << " requests from WebServer on port " << server->get_port() << endl;
+        }
+
         int port = server->get_port();
+        provisionedCost -= server->get_type().cost;
         delete server;
-        activeServers--;
-        if(currentServer != 0){
-            currentServer--;
+        servers.erase(servers.begin() + index);
+        for (int& slot : sessionSlots) {
+            if (slot == index) {
+                slot = -1;
+            } else if (slot > index) {
+                slot--;
+            }
         }
-        servers.pop_back();
-        cout << "[INFO] Removed WebServer on port " << port << ". Total servers: " << servers.size() << endl;
+        while (!sessionSlots.empty() && sessionSlots.back() < 0) sessionSlots.pop_back();
+        drainingServers--;
+        drainedServers++;
+        if (index < currentServer) currentServer--;
+        if (currentServer >= (int) servers.size()) currentServer = 0;
+        if (verbose) cout << "[INFO] Removed WebServer on port " << port << ". Total servers: " << servers.size() << endl;
     }
 }
 
 /**
  * @brief Adjusts the number of active servers based on the request queue size.
  *
- * Adds or removes servers depending on the current demand based on the queue size.
+ * Adds or removes servers depending on the current demand based on the queue size,
+ * using the per-server thresholds set by set_scaling_thresholds().
  */
 void LoadBalancer::adjust_servers() {
+    TraceSpan span("LoadBalancer::adjust_servers");
     int queueSize = get_queue_size();
-    if (queueSize > (int) servers.size() * 5) {
+    int serving = servers.size() - drainingServers;
+    if (queueSize > serving * scaleUpFactor) {
         add_server();
-    } else if ((queueSize < (int) servers.size() * 2) && servers.size() > 1) {
+    } else if ((queueSize < serving * scaleDownFactor) && serving > 1) {
         remove_server();
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Finds the first server in rotation, starting from a given index.
+ *
+ * Skips draining servers and servers the HealthChecker has ejected. If every
+ * serving server is ejected, the first serving one from the start index is
+ * returned (panic routing).
+ *
+ * @param start Index to start searching from.
+ * @return Index of the chosen server.
+ */
+int LoadBalancer::next_available_server(int start) {
+    int size = servers.size();
+    int fallback = -1;
+    for (int i = 0; i < size; ++i) {
+        int index = (start + i) % size;
+        if (servers[index]->is_draining()) continue;
+        if (!healthChecking || healthChecker.is_available(*servers[index])) return index;
+        if (fallback < 0) fallback = index;
+    }
+    return fallback < 0 ? start : fallback;
+}
+
+/**
+ * @brief Chooses the server that will handle a request.
+ *
+ * With sticky sessions enabled, the configured header's value is mapped onto the
+ * session slots with jump consistent hashing. Each server keeps its slot while it
+ * is in the pool and a released server's slot forwards to the next occupied one,
+ * so adding or removing a server only moves about 1/n of sessions; if that server
+ * is draining or ejected the next one in rotation is used. Other
+ * requests follow the dispatch policy: round-robin takes the next server in
+ * rotation with room for the request and advances currentServer, while
+ * fastest-completion takes the server with the lowest expected completion time.
+ * Ejected servers are skipped unless every server is ejected.
+ *
+ * @param request The request being dispatched.
+ * @return Index of the chosen server, or -1 if the request must wait for a slot.
+ */
+int LoadBalancer::select_server(const Request& request) {
+    if (servers.empty()) return -1;
+    if (!stickyHeader.empty()) {
+        string session = request.get_header(stickyHeader);
+        if (!session.empty()) {
+            int slot = jump_consistent_hash(fnv1a_hash(session), sessionSlots.size());
+            while (sessionSlots[slot] < 0) slot = (slot + 1) % sessionSlots.size();
+            int index = next_available_server(sessionSlots[slot]);
+            return servers[index]->can_accept(request) ? index : -1;
+        }
+    }
+
+    int size = servers.size();
+    bool panic = healthChecking && !healthChecker.is_available(*servers[next_available_server(currentServer)]);
+    auto inRotation = [&](int index) {
+        if (servers[index]->is_draining()) return false;
+        return !healthChecking || panic || healthChecker.is_available(*servers[index]);
+    };
+    if (dispatchPolicy == DispatchPolicy::FASTEST_COMPLETION) {
+        int best = -1;
+        double bestTime = 0.0;
+        for (int index = 0; index < size; ++index) {
+            if (!inRotation(index)) continue;
+            double time = servers[index]->expected_completion(request);
+            if (best < 0 || time < bestTime) {
+                best = index;
+                bestTime = time;
+            }
+        }
+        return best >= 0 && servers[best]->can_accept(request) ? best : -1;
+    }
+    for (int i = 0; i < size; ++i) {
+        int index = (currentServer + i) % size;
+        if (inRotation(index) && servers[index]->can_accept(request)) {
+            currentServer = (index + 1) % size;
+            return index;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Enables the in-balancer response cache for GET requests.
+ *
+ * @param shards Number of independently locked cache shards.
+ * @param memoryBudget Total bytes the cache may hold.
+ * @param ttl Time-to-live of a cached response, in cycles.
+ */
+void LoadBalancer::enable_cache(int shards, size_t memoryBudget, int ttl) {
+    cache = std::make_unique<ResponseCache>(shards, memoryBudget, ttl);
+}
+
+/**
+ * @brief Publishes the LoadBalancer's counters, gauges and latency histogram.
+ *
+ * Gauges are refreshed at the start of every cycle.
+ *
+ * @param registry The registry to register metrics in.
+ * @param labels Prometheus label set without braces; empty for none.
+ */
+void LoadBalancer::enable_metrics(MetricsRegistry& registry, const std::string& labels) {
+    metrics = std::make_unique<Instruments>();
+    metrics->cycles = registry.counter("lb_cycles_total", "Simulation cycles run.", labels);
+    metrics->requests = registry.counter("lb_requests_total", "Requests received.", labels);
+    metrics->cacheHits = registry.counter("lb_cache_hits_total", "Requests answered from the response cache.", labels);
+    metrics->completed = registry.counter("lb_requests_completed_total", "Requests completed by a server.", labels);
+    metrics->failures = registry.counter("lb_server_failures_total", "Failed calls to a server.", labels);
+    metrics->expired = registry.counter("lb_requests_expired_total", "Requests dropped or cancelled after their deadline, or too large for every server.", labels);
+    metrics->handoffs = registry.counter("lb_requests_handed_off_total", "In-flight requests handed back to the queue by draining servers.", labels);
+    metrics->queueSize = registry.gauge("lb_queue_size", "Requests waiting in the queue.", labels);
+    metrics->servers = registry.gauge("lb_servers", "Servers provisioned.", labels);
+    metrics->latency = registry.histogram("lb_request_latency_cycles", "Request latency from arrival to completion, in cycles.", labels);
+    metrics->drainLatency = registry.histogram("lb_drain_request_latency_cycles", "Latency of requests in flight on a server when it started draining, in cycles.", labels);
+    publish_gauges();
+}
+
+/**
+ * @brief Brings the queue and server gauges up to date.
+ *
+ * Gauges are adjusted by the change since the last report, so balancers sharing a
+ * gauge on one thread add up instead of overwriting each other.
+ */
+void LoadBalancer::publish_gauges() {
+    long long queued = requestQueue.get_size();
+    long long provisioned = servers.size();
+    metrics->queueSize->add(queued - metrics->reportedQueue);
+    metrics->servers->add(provisioned - metrics->reportedServers);
+    metrics->reportedQueue = queued;
+    metrics->reportedServers = provisioned;
+}
+
+/**
+ * @brief Gets the response cache.
+ *
+ * @return ResponseCache* The cache, or nullptr if caching is disabled.
+ */
+ResponseCache* LoadBalancer::get_cache() {
+    return cache.get();
+}
+
+/**
+ * @brief Enables sticky sessions keyed on a request header.
+ *
+ * @param header The header name to hash; an empty name disables sticky sessions.
+ */
+void LoadBalancer::set_sticky_header(const std::string& header) {
+    stickyHeader = header;
+}
+
+/**
+ * @brief Turns active health probes and outlier ejection on or off.
+ *
+ * @param enabled True to skip unhealthy servers when dispatching.
+ */
+void LoadBalancer::enable_health_checks(bool enabled) {
+    healthChecking = enabled;
+}
+
+/**
+ * @brief Gets the HealthChecker so its thresholds can be tuned.
+ *
+ * @return HealthChecker& The LoadBalancer's HealthChecker.
+ */
+HealthChecker& LoadBalancer::get_health_checker() {
+    return healthChecker;
+}
+
+/**
+ * @brief Gets a server by index.
+ *
+ * @param index Position of the server in the pool.
+ * @return WebServer* The server, or nullptr if the index is out of range.
+ */
+WebServer* LoadBalancer::get_server(int index) {
+    if (index < 0 || index >= (int) servers.size()) return nullptr;
+    return servers[index];
+}
+
+/**
+ * @brief Gets the aggregate load signal a parent balancer routes on.
+ *
+ * @return LoadSignal The queue size and server count, stamped with the current cycle.
+ */
+LoadSignal LoadBalancer::get_load_signal() {
+    LoadSignal signal;
+    signal.queueSize = requestQueue.get_size();
+    signal.servers = servers.size() - drainingServers;
+    signal.cycle = count;
+    return signal;
+}
+
+/**
+ * @brief Gets the number of cycles the LoadBalancer has run.
+ *
+ * @return int The current simulation cycle.
+ */
+int LoadBalancer::get_cycle() const {
+    return count;
+}
+
+/**
+ * @brief Sets the queue-length thresholds used by adjust_servers().
+ *
+ * @param scaleUp Requests per server above which to scale up.
+ * @param scaleDown Requests per server below which to scale down.
+ */
+void LoadBalancer::set_scaling_thresholds(int scaleUp, int scaleDown) {
+    scaleUpFactor = scaleUp;
+    scaleDownFactor = scaleDown;
+}
+
+/**
+ * @brief Gets the number of requests completed by the servers.
+ *
+ * @return long long Completed request count.
+ */
+long long LoadBalancer::get_completed_requests() const {
+    return completedRequests;
+}
+
+/**
+ * @brief Drops requests whose deadline has passed from the front of the queue.
+ *
+ * Only the front is checked. In EDF order, or in FIFO order with one timeout for
+ * every request, expired requests are always at the front. Otherwise an expired
+ * request further back is dropped when it reaches the front, still before a server
+ * spends a cycle on it. A request not yet started that could not finish before its
+ * deadline even if served every cycle is dropped too, since serving it would only
+ * waste cycles. A request dropped part way through service is counted as
+ * cancelled, and the cycles already spent on it as wasted.
+ */
+void LoadBalancer::drop_expired() {
+    double fastest = -1.0;
+    while (!requestQueue.is_empty() && requestQueue.get_front_request().get_deadline() >= 0) {
+        const Request& request = requestQueue.get_front_request();
+        if (fastest < 0.0) {
+            fastest = 0.0;
+            for (const WebServer* server : servers) fastest = std::max(fastest, server->get_type().speed);
+        }
+        bool doomed = fastest > 0.0 && request.get_served_cycles() == 0
+            && request.is_expired(count + (int) std::ceil(request.get_task_time() / fastest) - 1);
+        if (!doomed && !request.is_expired(count)) break;
+        record_expired(request);
+        requestQueue.remove_request();
+    }
+}
+
+/**
+ * @brief Counts and logs a request dropped or cancelled after its deadline.
+ *
+ * A request a server has already spent cycles on is counted as cancelled and
+ * those cycles as wasted; any other as expired.
+ *
+ * @param request The request being dropped.
+ */
+void LoadBalancer::record_expired(const Request& request) {
+    if (request.get_served_cycles() > 0) {
+        cancelledRequests++;
+        wastedCycles += request.get_served_cycles();
+    } else {
+        expiredRequests++;
+    }
+    if (metrics) metrics->expired->inc();
+    if (verbose) cout << "[INFO] Dropped " << request.get_url() << " after its deadline." << endl;
+}
+
+/**
+ * @brief Checks whether a request fits the memory of some server that is or could be provisioned.
+ *
+ * Without configured instance types new servers are standard, with unlimited memory.
+ *
+ * @param request The request to place.
+ * @return true If some server or instance type has no memory limit or room for the request's response.
+ */
+bool LoadBalancer::fits_any_server(const Request& request) const {
+    if (instanceTypes.empty()) return true;
+    long long size = request.get_size();
+    for (const InstanceType& type : instanceTypes) {
+        if (type.memory <= 0 || size <= type.memory) return true;
+    }
+    for (const WebServer* server : servers) {
+        if (server->get_type().memory <= 0 || size <= server->get_type().memory) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Gives every request without a deadline one a fixed number of cycles after arrival.
+ *
+ * @param cycles Cycles a client waits before giving up; 0 for no timeout.
+ */
+void LoadBalancer::set_request_timeout(int cycles) {
+    requestTimeout = cycles;
+}
+
+/**
+ * @brief Sets the order in which queued requests are served.
+ *
+ * @param order QueueOrder::FIFO or QueueOrder::EDF.
+ */
+void LoadBalancer::set_queue_order(QueueOrder order) {
+    requestQueue.set_order(order);
+}
+
+/**
+ * @brief Gets the number of requests dropped before being served, after their deadline or for lack of memory.
+ *
+ * @return long long Expired request count.
+ */
+long long LoadBalancer::get_expired_requests() const {
+    return expiredRequests;
+}
+
+/**
+ * @brief Gets the number of requests cancelled part way through service.
+ *
+ * @return long long Cancelled request count.
+ */
+long long LoadBalancer::get_cancelled_requests() const {
+    return cancelledRequests;
+}
+
+/**
+ * @brief Gets the server cycles spent on requests that were later cancelled.
+ *
+ * @return long long Wasted cycles.
+ */
+long long LoadBalancer::get_wasted_cycles() const {
+    return wastedCycles;
+}
+
+/**
+ * @brief Gets the server-cycles spent so far.
+ *
+ * @return long long The sum over all cycles of the number of servers provisioned.
+ */
+long long LoadBalancer::get_server_cycles() const {
+    return serverCycles;
+}
+
+/**
+ * @brief Gets the price of the servers provisioned so far.
+ *
+ * @return double The sum over all cycles of the cost per cycle of every server provisioned.
+ */
+double LoadBalancer::get_server_cost() const {
+    return serverCost;
+}
+
+/**
+ * @brief Sets the instance types add_server() provisions.
+ *
+ * @param types The instance types, in provisioning order; empty for standard servers.
+ */
+void LoadBalancer::set_instance_types(const std::vector<InstanceType>& types) {
+    instanceTypes = types;
+}
+
+/**
+ * @brief Sets how servers are picked for requests without a sticky session.
+ *
+ * @param policy The dispatch policy.
+ */
+void LoadBalancer::set_dispatch_policy(DispatchPolicy policy) {
+    dispatchPolicy = policy;
+}
+
+/**
+ * @brief Gets the number of requests being served.
+ *
+ * @return int Requests in flight across all servers.
+ */
+int LoadBalancer::get_in_flight_requests() const {
+    int total = 0;
+    for (const WebServer* server : servers) total += server->get_in_flight();
+    return total;
+}
+
+/**
+ * @brief Sets how long a draining server may keep serving before its requests are handed off.
+ *
+ * @param cycles Longest drain in cycles; 0 hands off at once, negative waits for every request.
+ */
+void LoadBalancer::set_drain_timeout(int cycles) {
+    drainTimeout = cycles;
+}
+
+/**
+ * @brief Sets how many queued requests distribute_requests() may start per cycle.
+ *
+ * @param requests Largest batch; values below 1 are treated as 1.
+ */
+void LoadBalancer::set_dispatch_batch(int requests) {
+    batchSize = std::max(1, requests);
+}
+
+/**
+ * @brief Gets the number of servers draining.
+ *
+ * @return int Servers taking no new requests that have not been released yet.
+ */
+int LoadBalancer::get_draining_servers() const {
+    return drainingServers;
+}
+
+/**
+ * @brief Gets the number of servers released after draining.
+ *
+ * @return long long Released server count.
+ */
+long long LoadBalancer::get_drained_servers() const {
+    return drainedServers;
+}
+
+/**
+ * @brief Gets the number of in-flight requests handed back to the queue by draining servers.
+ *
+ * @return long long Handed-off request count.
+ */
+long long LoadBalancer::get_handed_off_requests() const {
+    return handedOffRequests;
+}
+
+/**
+ * @brief Gets the latencies of requests that were in the balancer when a scale-down began.
+ *
+ * @return const LatencyHistogram& Latencies from arrival to completion, in cycles.
+ */
+const LatencyHistogram& LoadBalancer::get_drain_latency_histogram() const {
+    return drainLatencies;
+}
+
+/**
+ * @brief Gets the histogram of request latencies.
+ *
+ * @return const LatencyHistogram& Latencies from arrival to completion, in cycles.
+ */
+const LatencyHistogram& LoadBalancer::get_latency_histogram() const {
+    return latencies;
+}
+
+/**
+ * @brief Turns per-cycle console logging on or off.
+ *
+ * @param enabled False to keep the LoadBalancer and its HealthChecker silent.
+ */
+void LoadBalancer::set_verbose(bool enabled) {
+    verbose = enabled;
+    healthChecker.set_verbose(enabled);
+}
+
+/**
+ * @brief Seeds every random source owned by the LoadBalancer.
+ *
+ * The request queue gets its own stream derived from the seed.
+ *
+ * @param seed Any 64-bit value.
+ */
+void LoadBalancer::seed(uint64_t seed) {
+    rng.seed(derive_seed(seed, 1));
+    requestQueue.seed(derive_seed(seed, 2));
+}
+
+/**
+ * @brief Sets the longest simulated processing delay of a completed request.
+ *
+ * @param milliseconds Upper bound of the wall-clock delay; 0 disables it.
+ */
+void LoadBalancer::set_max_processing_delay(int milliseconds) {
+    requestQueue.set_max_processing_delay(milliseconds);
+}
+
+/**
+ * @brief Writes the complete LoadBalancer state to a binary snapshot.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void LoadBalancer::save(std::ostream& out) const {
+    write_value(out, currentServer);
+    write_value(out, numServers);
+    write_value(out, maxServers);
+    write_value(out, activeServers);
+    write_value(out, count);
+    write_value(out, healthChecking);
+    write_value(out, scaleUpFactor);
+    write_value(out, scaleDownFactor);
+    write_value(out, completedRequests);
+    write_value(out, serverCycles);
+    write_value(out, requestTimeout);
+    write_value(out, expiredRequests);
+    write_value(out, cancelledRequests);
+    write_value(out, wastedCycles);
+    write_value(out, serverCost);
+    write_value(out, dispatchPolicy);
+    write_value(out, batchSize);
+    write_value(out, drainTimeout);
+    write_value(out, drainedServers);
+    write_value(out, handedOffRequests);
+    write_value<uint32_t>(out, instanceTypes.size());
+    for (const InstanceType& type : instanceTypes) {
+        write_string(out, type.name);
+        write_value(out, type.speed);
+        write_value(out, type.slots);
+        write_value(out, type.memory);
+        write_value(out, type.cost);
+    }
+    latencies.save(out);
+    drainLatencies.save(out);
+    write_string(out, stickyHeader);
+    rng.save(out);
+    healthChecker.save(out);
+
+    write_value<uint32_t>(out, servers.size());
+    for (const WebServer* server : servers) {
+        server->save(out);
+    }
+    write_value<uint32_t>(out, sessionSlots.size());
+    for (int slot : sessionSlots) {
+        write_value(out, slot);
+    }
+    requestQueue.save(out);
+
+    write_value<bool>(out, cache != nullptr);
+    if (cache) cache->save(out);
+}
+
+/**
+ * @brief Replaces the LoadBalancer's state with a snapshot written by save().
+ *
+ * Existing servers are deleted and rebuilt from the snapshot. On failure the
+ * LoadBalancer is left in an unspecified but safe-to-destroy state.
+ *
+ * @param in Stream opened in binary mode.
+ * @return true On success.
+ */
+bool LoadBalancer::restore(std::istream& in) {
+    uint32_t serverCount = 0;
+    uint32_t typeCount = 0;
+    if (!read_value(in, currentServer) || !read_value(in, numServers) || !read_value(in, maxServers)
+        || !read_value(in, activeServers) || !read_value(in, count) || !read_value(in, healthChecking)
+        || !read_value(in, scaleUpFactor) || !read_value(in, scaleDownFactor) || !read_value(in, completedRequests)
+        || !read_value(in, serverCycles) || !read_value(in, requestTimeout) || !read_value(in, expiredRequests)
+        || !read_value(in, cancelledRequests) || !read_value(in, wastedCycles)
+        || !read_value(in, serverCost) || !read_value(in, dispatchPolicy)
+        || !read_value(in, batchSize) || !read_value(in, drainTimeout) || !read_value(in, drainedServers) || !read_value(in, handedOffRequests) || !read_value(in, typeCount)) {
+        return false;
+    }
+    if (batchSize < 1 || requestTimeout < 0 || maxServers < 0
+        || (dispatchPolicy != DispatchPolicy::ROUND_ROBIN && dispatchPolicy != DispatchPolicy::FASTEST_COMPLETION)
+        || !stream_has(in, (uint64_t) typeCount * INSTANCE_TYPE_MIN_BYTES)) {
+        return false;
+    }
+    instanceTypes.assign(typeCount, InstanceType());
+    for (InstanceType& type : instanceTypes) {
+        if (!read_string(in, type.name) || !read_value(in, type.speed) || !read_value(in, type.slots)
+            || !read_value(in, type.memory) || !read_value(in, type.cost) || !is_valid_instance_type(type)) {
+            return false;
+        }
+    }
+    if (!latencies.restore(in) || !drainLatencies.restore(in) || !read_string(in, stickyHeader) || !rng.restore(in) || !healthChecker.restore(in)
+        || !read_value(in, serverCount)) {
+        return false;
+    }
+
+    for (WebServer* server : servers) {
+        delete server;
+    }
+    servers.clear();
+    provisionedCost = 0.0;
+    drainingServers = 0;
+    for (uint32_t i = 0; i < serverCount; ++i) {
+        servers.push_back(new WebServer());
+        if (!servers.back()->restore(in)) return false;
+        provisionedCost += servers.back()->get_type().cost;
+        if (servers.back()->is_draining()) drainingServers++;
+    }
+    if (currentServer < 0 || currentServer >= std::max<int>(1, serverCount)) return false;
+    uint32_t slotCount = 0;
+    if (!read_value(in, slotCount) || slotCount < serverCount || !stream_has(in, (uint64_t) slotCount * sizeof(int))) {
+        return false;
+    }
+    sessionSlots.assign(slotCount, -1);
+    uint32_t occupied = 0;
+    for (int& slot : sessionSlots) {
+        if (!read_value(in, slot) || slot < -1 || slot >= (int) serverCount) return false;
+        if (slot >= 0) occupied++;
+    }
+    if (occupied != serverCount || (slotCount > 0 && sessionSlots.back() < 0)) return false;
+    if (!requestQueue.restore(in)) return false;
+
+    bool hasCache = false;
+    if (!read_value(in, hasCache)) return false;
+    cache.reset();
+    if (hasCache) {
+        cache = std::make_unique<ResponseCache>(1, 0, 0);
+        if (!cache->restore(in)) return false;
+    }
+    return true;
+}
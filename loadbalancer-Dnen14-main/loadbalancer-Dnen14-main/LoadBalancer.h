@@ -20,8 +20,38 @@
 
 #include "Webserver.h"
 #include "RequestQueue.h"
+#include "HealthChecker.h"
+#include "ResponseCache.h"
+#include "Random.h"
+#include "LatencyHistogram.h"
+#include "Metrics.h"
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
 
 
+/**
+ * @brief How a LoadBalancer picks a server for a request without a sticky session.
+ *
+ * ROUND_ROBIN cycles through the servers with a free slot. FASTEST_COMPLETION
+ * sends each request to the server expected to finish it first given its speed,
+ * and holds it back while that server is busy rather than starting it on a
+ * slower one.
+ */
+enum class DispatchPolicy { ROUND_ROBIN, FASTEST_COMPLETION };
+
+/**
+ * @struct LoadSignal
+ * @brief Aggregate load of a LoadBalancer, as reported to a parent balancer.
+ */
+struct LoadSignal {
+    int queueSize = 0;
+    int servers = 0;
+    int cycle = 0;
+};
+
 /**
  * @class LoadBalancer
  * @brief Manages a set of web servers and distributes incoming requests among them.
@@ -38,6 +68,122 @@ private:
     int maxServers;
     int activeServers;
     int count;
+    bool healthChecking;
+    bool verbose;
+    HealthChecker healthChecker;
+    std::unique_ptr<ResponseCache> cache;
+    std::string stickyHeader;
+    std::vector<int> sessionSlots;
+    Rng rng;
+    int scaleUpFactor;
+    int scaleDownFactor;
+    long long completedRequests;
+    long long serverCycles;
+    int requestTimeout;
+    long long expiredRequests;
+    long long cancelledRequests;
+    long long wastedCycles;
+    double serverCost;
+    double provisionedCost;
+    std::vector<InstanceType> instanceTypes;
+    DispatchPolicy dispatchPolicy;
+    int drainingServers;
+    int drainTimeout;
+    long long drainedServers;
+    long long handedOffRequests;
+    int batchSize;
+    std::vector<Request> batch;
+    LatencyHistogram latencies;
+    LatencyHistogram drainLatencies;
+
+    /**
+     * @brief Metrics updated by the LoadBalancer once enable_metrics() is called.
+     */
+    struct Instruments {
+        Counter* cycles;
+        Counter* requests;
+        Counter* cacheHits;
+        Counter* completed;
+        Counter* failures;
+        Counter* expired;
+        Counter* handoffs;
+        Gauge* queueSize;
+        Gauge* servers;
+        Histogram* latency;
+        Histogram* drainLatency;
+        long long reportedQueue = 0;
+        long long reportedServers = 0;
+    };
+    std::unique_ptr<Instruments> metrics;
+
+    /**
+     * @brief Brings the queue and server gauges up to date.
+     */
+    void publish_gauges();
+
+    /**
+     * @brief Drops requests that can no longer meet their deadline from the front of the queue.
+     */
+    void drop_expired();
+
+    /**
+     * @brief Counts and logs a request dropped or cancelled after its deadline.
+     *
+     * @param request The request being dropped.
+     */
+    void record_expired(const Request& request);
+
+    /**
+     * @brief Checks whether a request fits the memory of some server that is or could be provisioned.
+     *
+     * @param request The request to place.
+     */
+    bool fits_any_server(const Request& request) const;
+
+    /**
+     * @brief Takes a batch of requests from the front of the queue and starts each on the server chosen for it.
+     *
+     * Requests whose server has no room are returned to the front of the queue in order.
+     */
+    void dispatch_batch();
+
+    /**
+     * @brief Serves one cycle of every request in flight on a server.
+     *
+     * Completed requests leave the server; requests whose call fails are handed
+     * back to the queue to be retried, and expired ones are cancelled.
+     *
+     * @param server The server to run.
+     */
+    void serve_requests(WebServer& server);
+
+    /**
+     * @brief Releases draining servers that have finished or handed off their in-flight requests.
+     */
+    void release_drained();
+
+    /**
+     * @brief Finds the first server in rotation, starting from a given index.
+     *
+     * Skips draining servers and servers the HealthChecker has ejected. If every
+     * serving server is ejected the first one from the start index is returned, so
+     * traffic is never black-holed.
+     *
+     * @param start Index to start searching from.
+     * @return Index of the chosen server.
+     */
+    int next_available_server(int start);
+
+    /**
+     * @brief Chooses the server that will handle a request.
+     *
+     * Uses the sticky-session header when one is configured and present on the
+     * request, and the dispatch policy otherwise.
+     *
+     * @param request The request being dispatched.
+     * @return Index of the chosen server, or -1 if the request must wait for a slot.
+     */
+    int select_server(const Request& request);
 
 public:
 
@@ -67,7 +213,8 @@ public:
     /**
      * @brief Distributes requests among the available servers.
      * 
-     * Processes requests in the queue by delegating them to available web servers.
+     * Starts up to the dispatch batch size of requests from the front of the queue
+     * on servers with a free slot, then serves one cycle of every request in flight.
      */
     void distribute_requests();
 
@@ -88,14 +235,25 @@ public:
     /**
      * @brief Adds a new server to the LoadBalancer.
      * 
-     * If the maximum number of servers has not been reached, a new server is created and added.
+     * A draining server is put back in rotation if there is one. Otherwise, if the
+     * maximum number of servers has not been reached, a new server is created and
+     * added; its instance type follows the mix set by set_instance_types().
      */
     void add_server();
 
+    /**
+     * @brief Adds a new server of a given instance type.
+     *
+     * @param type The capacity and price of the new server.
+     */
+    void add_server(const InstanceType& type);
+
     /**
      * @brief Removes a server from the LoadBalancer.
      * 
-     * If more than one server is active, the last server is removed.
+     * If more than one server is serving, the one with the least remaining work
+     * starts draining: it gets no new requests and is released once its in-flight
+     * requests finish, or once the drain timeout hands them back to the queue.
      */
     void remove_server();
 
@@ -112,6 +270,275 @@ public:
      * Outputs the current size of the request queue to the console.
      */
     void print_remaining_requests();
+
+    /**
+     * @brief Turns active health probes and outlier ejection on or off.
+     *
+     * @param enabled True to skip unhealthy servers when dispatching.
+     */
+    void enable_health_checks(bool enabled);
+
+    /**
+     * @brief Gets the HealthChecker so its thresholds can be tuned.
+     *
+     * @return A reference to the LoadBalancer's HealthChecker.
+     */
+    HealthChecker& get_health_checker();
+
+    /**
+     * @brief Enables the in-balancer response cache for GET requests.
+     *
+     * @param shards Number of independently locked cache shards.
+     * @param memoryBudget Total bytes the cache may hold.
+     * @param ttl Time-to-live of a cached response, in cycles.
+     */
+    void enable_cache(int shards, size_t memoryBudget, int ttl);
+
+    /**
+     * @brief Publishes the LoadBalancer's counters, gauges and latency histogram.
+     *
+     * Balancers given the same registry and labels share their metrics, which then
+     * report the sum over those balancers. Metrics are not part of a snapshot.
+     *
+     * @param registry The registry to register metrics in; must outlive the LoadBalancer.
+     * @param labels Prometheus label set without braces, e.g. `shard="2"`; empty for none.
+     */
+    void enable_metrics(MetricsRegistry& registry, const std::string& labels = "");
+
+    /**
+     * @brief Gets the response cache.
+     *
+     * @return The cache, or nullptr if caching is disabled.
+     */
+    ResponseCache* get_cache();
+
+    /**
+     * @brief Enables sticky sessions keyed on a request header.
+     *
+     * Requests carrying the header are always sent to the same server while the
+     * pool size is unchanged; an empty name disables sticky sessions.
+     *
+     * @param header The header name to hash, e.g. "Cookie".
+     */
+    void set_sticky_header(const std::string& header);
+
+    /**
+     * @brief Gets a server by index, e.g. to inject faults in a simulation.
+     *
+     * @param index Position of the server in the pool.
+     * @return The server, or nullptr if the index is out of range.
+     */
+    WebServer* get_server(int index);
+
+    /**
+     * @brief Sets the queue-length thresholds used by adjust_servers().
+     *
+     * A server is added while the queue holds more than scaleUp requests per server
+     * and removed while it holds fewer than scaleDown per server.
+     *
+     * @param scaleUp Requests per server above which to scale up (default 5).
+     * @param scaleDown Requests per server below which to scale down (default 2).
+     */
+    void set_scaling_thresholds(int scaleUp, int scaleDown);
+
+    /**
+     * @brief Gets the number of requests completed by the servers.
+     *
+     * @return Completed request count.
+     */
+    long long get_completed_requests() const;
+
+    /**
+     * @brief Gets the server-cycles spent so far, the cost of the run.
+     *
+     * @return The sum over all cycles of the number of servers provisioned.
+     */
+    long long get_server_cycles() const;
+
+    /**
+     * @brief Gets the price of the servers provisioned so far.
+     *
+     * @return The sum over all cycles of the cost per cycle of every server provisioned.
+     */
+    double get_server_cost() const;
+
+    /**
+     * @brief Sets the instance types add_server() provisions.
+     *
+     * Each new server gets the listed type with the fewest serving servers, so
+     * scaling up and down keeps the mix. An empty list provisions standard servers.
+     *
+     * @param types The instance types, in provisioning order.
+     */
+    void set_instance_types(const std::vector<InstanceType>& types);
+
+    /**
+     * @brief Sets how servers are picked for requests without a sticky session.
+     *
+     * @param policy DispatchPolicy::ROUND_ROBIN (the default) or DispatchPolicy::FASTEST_COMPLETION.
+     */
+    void set_dispatch_policy(DispatchPolicy policy);
+
+    /**
+     * @brief Gets the number of requests being served.
+     *
+     * @return Requests in flight across all servers.
+     */
+    int get_in_flight_requests() const;
+
+    /**
+     * @brief Sets how long a draining server may keep serving before its requests are handed off.
+     *
+     * Handed-off requests go back to the front of the queue with the work already
+     * done on them, and the server is released.
+     *
+     * @param cycles Longest drain in cycles; 0 hands off at once, negative waits for every request to finish (the default).
+     */
+    void set_drain_timeout(int cycles);
+
+    /**
+     * @brief Sets how many queued requests distribute_requests() may start per cycle.
+     *
+     * The whole batch is taken from the queue in one call and assigned in one pass
+     * with the active policy, after a single scaling decision.
+     *
+     * @param requests Largest batch; 1 (the default) starts one request per cycle.
+     */
+    void set_dispatch_batch(int requests);
+
+    /**
+     * @brief Gets the number of servers draining.
+     *
+     * @return Servers taking no new requests that have not been released yet.
+     */
+    int get_draining_servers() const;
+
+    /**
+     * @brief Gets the number of servers released after draining.
+     *
+     * @return Released server count.
+     */
+    long long get_drained_servers() const;
+
+    /**
+     * @brief Gets the number of in-flight requests handed back to the queue by draining servers.
+     *
+     * @return Handed-off request count.
+     */
+    long long get_handed_off_requests() const;
+
+    /**
+     * @brief Gets the latencies of requests caught by a scale-down.
+     *
+     * Compared with get_latency_histogram() this shows what scaling down costs, and
+     * so how far the scale-down threshold can safely be raised.
+     *
+     * @return The latency histogram of requests that were in flight on a server when it
+     * started draining, including any later handed back to the queue.
+     */
+    const LatencyHistogram& get_drain_latency_histogram() const;
+
+    /**
+     * @brief Gives every request without a deadline one a fixed number of cycles after arrival.
+     *
+     * @param cycles Cycles a client waits before giving up; 0 for no timeout.
+     */
+    void set_request_timeout(int cycles);
+
+    /**
+     * @brief Sets the order in which queued requests are served.
+     *
+     * @param order QueueOrder::FIFO (the default) or QueueOrder::EDF.
+     */
+    void set_queue_order(QueueOrder order);
+
+    /**
+     * @brief Gets the number of requests dropped before any server time was spent on them.
+     *
+     * These are requests whose deadline passed while queued, and requests larger
+     * than the memory of every instance type, which no server could ever start.
+     *
+     * @return Expired request count.
+     */
+    long long get_expired_requests() const;
+
+    /**
+     * @brief Gets the number of requests cancelled part way through service because their deadline passed.
+     *
+     * @return Cancelled request count.
+     */
+    long long get_cancelled_requests() const;
+
+    /**
+     * @brief Gets the server cycles spent on requests that were later cancelled.
+     *
+     * @return Wasted cycles.
+     */
+    long long get_wasted_cycles() const;
+
+    /**
+     * @brief Gets the histogram of request latencies (arrival to completion, in cycles).
+     *
+     * @return The latency histogram.
+     */
+    const LatencyHistogram& get_latency_histogram() const;
+
+    /**
+     * @brief Turns per-cycle console logging on or off.
+     *
+     * Logging is on by default; benchmarks and batch simulations turn it off.
+     *
+     * @param enabled False to keep the LoadBalancer and its HealthChecker silent.
+     */
+    void set_verbose(bool enabled);
+
+    /**
+     * @brief Seeds every random source owned by the LoadBalancer.
+     *
+     * Together with a seeded Workload this makes a run fully reproducible.
+     *
+     * @param seed Any 64-bit value.
+     */
+    void seed(uint64_t seed);
+
+    /**
+     * @brief Sets the longest simulated processing delay of a completed request.
+     *
+     * @param milliseconds Upper bound of the wall-clock delay; 0 disables it.
+     */
+    void set_max_processing_delay(int milliseconds);
+
+    /**
+     * @brief Writes the complete LoadBalancer state to a binary snapshot.
+     *
+     * Covers the clock, servers, queue, cache, configuration and random state, so a
+     * restored LoadBalancer continues exactly as the saved one would have.
+     *
+     * @param out Stream opened in binary mode.
+     */
+    void save(std::ostream& out) const;
+
+    /**
+     * @brief Replaces the LoadBalancer's state with a snapshot written by save().
+     *
+     * @param in Stream opened in binary mode.
+     * @return True on success.
+     */
+    bool restore(std::istream& in);
+
+    /**
+     * @brief Gets the aggregate load signal a parent balancer routes on.
+     *
+     * @return The queue size and server count, stamped with the current cycle.
+     */
+    LoadSignal get_load_signal();
+
+    /**
+     * @brief Gets the number of cycles the LoadBalancer has run.
+     *
+     * @return The current simulation cycle.
+     */
+    int get_cycle() const;
 };
 
 #endif
@@ -0,0 +1,59 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/**
+ * @file Mailbox.h
+ * @brief Defines the Mailbox class template, a blocking FIFO used to pass messages between threads.
+ */
+
+/**
+ * @class Mailbox
+ * @brief An unbounded multi-producer, single-consumer message queue.
+ *
+ * Messages from one sender are received in the order they were sent. Sending a
+ * message happens-before its receipt, so a receiver may read anything the sender
+ * wrote before sending without further synchronisation.
+ *
+ * @tparam T The message type; moved in and out of the queue.
+ */
+template <typename T>
+class Mailbox {
+private:
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<T> messages;
+
+public:
+
+    /**
+     * @brief Appends a message and wakes the receiver.
+     *
+     * @param message The message to send.
+     */
+    void send(T message) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            messages.push_back(std::move(message));
+        }
+        ready.notify_one();
+    }
+
+    /**
+     * @brief Removes the oldest message, blocking until one is available.
+     *
+     * @return The message.
+     */
+    T receive() {
+        std::unique_lock<std::mutex> guard(lock);
+        ready.wait(guard, [this] { return !messages.empty(); });
+        T message = std::move(messages.front());
+        messages.pop_front();
+        return message;
+    }
+};
+
+#endif
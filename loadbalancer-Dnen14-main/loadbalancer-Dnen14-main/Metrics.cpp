@@ -0,0 +1,193 @@
+/**
+ * @file Metrics.cpp
+ * @brief Implementation of the metrics registry and its metric types.
+ *
+ * @see MetricsRegistry
+ *
+ */
+
+#include "Metrics.h"
+
+/**
+ * @brief Hands out thread slots in creation order.
+ *
+ * Called once per thread, from metric_slot(); threads beyond the first
+ * METRIC_SLOTS - 1 all share the last slot.
+ *
+ * @return int The next free slot, or the shared last slot once the others are taken.
+ */
+int next_metric_slot() {
+    static std::atomic<int> nextSlot(0);
+    int slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+    return slot < METRIC_SLOTS - 1 ? slot : METRIC_SLOTS - 1;
+}
+
+/**
+ * @brief Gets the count summed over all threads.
+ *
+ * @return long long The count.
+ */
+long long Counter::value() const {
+    long long total = 0;
+    for (const MetricCell& cell : cells) total += cell.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+/**
+ * @brief Gets the value summed over all threads.
+ *
+ * @return long long The value.
+ */
+long long Gauge::value() const {
+    long long total = 0;
+    for (const MetricCell& cell : cells) total += cell.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+/**
+ * @brief Gets the number of values in each bucket, summed over all threads.
+ *
+ * @return std::vector<long long> One count per bucket.
+ */
+std::vector<long long> Histogram::bucket_counts() const {
+    std::vector<long long> counts(BUCKETS, 0);
+    for (const Slot& slot : slots) {
+        for (int i = 0; i < BUCKETS; ++i) counts[i] += slot.counts[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+/**
+ * @brief Gets the sum of every recorded value.
+ *
+ * @return long long The sum.
+ */
+long long Histogram::sum() const {
+    long long total = 0;
+    for (const Slot& slot : slots) total += slot.sum.load(std::memory_order_relaxed);
+    return total;
+}
+
+/**
+ * @brief Finds or creates an entry.
+ *
+ * @param name Metric name.
+ * @param help One-line description, kept from the first registration.
+ * @param labels Label set without braces.
+ * @param type Metric type.
+ * @return Entry* The entry, or nullptr if the name is registered as another type.
+ */
+MetricsRegistry::Entry* MetricsRegistry::find_or_add(const std::string& name, const std::string& help,
+                                                     const std::string& labels, Type type) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (std::unique_ptr<Entry>& entry : entries) {
+        if (entry->name != name) continue;
+        if (entry->type != type) return nullptr;
+        if (entry->labels == labels) return entry.get();
+    }
+    std::unique_ptr<Entry> entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->labels = labels;
+    entry->help = help;
+    entry->type = type;
+    if (type == COUNTER) entry->counter = std::make_unique<Counter>();
+    if (type == GAUGE) entry->gauge = std::make_unique<Gauge>();
+    if (type == HISTOGRAM) entry->histogram = std::make_unique<Histogram>();
+    entries.push_back(std::move(entry));
+    return entries.back().get();
+}
+
+/**
+ * @brief Gets or creates a counter.
+ *
+ * @param name Metric name.
+ * @param help One-line description.
+ * @param labels Label set without braces; empty for none.
+ * @return Counter* The counter, or nullptr if the name is registered as another type.
+ */
+Counter* MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    Entry* entry = find_or_add(name, help, labels, COUNTER);
+    return entry ? entry->counter.get() : nullptr;
+}
+
+/**
+ * @brief Gets or creates a gauge.
+ *
+ * @param name Metric name.
+ * @param help One-line description.
+ * @param labels Label set without braces; empty for none.
+ * @return Gauge* The gauge, or nullptr if the name is registered as another type.
+ */
+Gauge* MetricsRegistry::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    Entry* entry = find_or_add(name, help, labels, GAUGE);
+    return entry ? entry->gauge.get() : nullptr;
+}
+
+/**
+ * @brief Gets or creates a histogram.
+ *
+ * @param name Metric name.
+ * @param help One-line description.
+ * @param labels Label set without braces; empty for none.
+ * @return Histogram* The histogram, or nullptr if the name is registered as another type.
+ */
+Histogram* MetricsRegistry::histogram(const std::string& name, const std::string& help, const std::string& labels) {
+    Entry* entry = find_or_add(name, help, labels, HISTOGRAM);
+    return entry ? entry->histogram.get() : nullptr;
+}
+
+/**
+ * @brief Joins a label set and an extra label into Prometheus braces.
+ *
+ * @param labels Label set without braces.
+ * @param extra Extra label, e.g. le="4"; may be empty.
+ * @return std::string The braced label set, or empty if there are no labels.
+ */
+static std::string braces(const std::string& labels, const std::string& extra) {
+    if (labels.empty() && extra.empty()) return "";
+    if (labels.empty()) return "{" + extra + "}";
+    if (extra.empty()) return "{" + labels + "}";
+    return "{" + labels + "," + extra + "}";
+}
+
+/**
+ * @brief Writes every metric in the Prometheus text exposition format.
+ *
+ * Metrics sharing a name are grouped under one HELP and TYPE header, in order of
+ * first registration. Histogram buckets are cumulative, as the format requires.
+ *
+ * @param out Destination stream.
+ */
+void MetricsRegistry::write_prometheus(std::ostream& out) {
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<bool> written(entries.size(), false);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (written[i]) continue;
+        const Entry& first = *entries[i];
+        const char* type = first.type == COUNTER ? "counter" : first.type == GAUGE ? "gauge" : "histogram";
+        out << "# HELP " << first.name << " " << first.help << "\n";
+        out << "# TYPE " << first.name << " " << type << "\n";
+
+        for (size_t j = i; j < entries.size(); ++j) {
+            const Entry& entry = *entries[j];
+            if (entry.name != first.name) continue;
+            written[j] = true;
+            if (entry.type == COUNTER) {
+                out << entry.name << braces(entry.labels, "") << " " << entry.counter->value() << "\n";
+            } else if (entry.type == GAUGE) {
+                out << entry.name << braces(entry.labels, "") << " " << entry.gauge->value() << "\n";
+            } else {
+                std::vector<long long> counts = entry.histogram->bucket_counts();
+                long long cumulative = 0;
+                for (int b = 0; b < Histogram::BUCKETS; ++b) {
+                    cumulative += counts[b];
+                    std::string bound = b == Histogram::BUCKETS - 1 ? "+Inf" : std::to_string(1LL << b);
+                    out << entry.name << "_bucket" << braces(entry.labels, "le=\"" + bound + "\"") << " "
+                        << cumulative << "\n";
+                }
+                out << entry.name << "_sum" << braces(entry.labels, "") << " " << entry.histogram->sum() << "\n";
+                out << entry.name << "_count" << braces(entry.labels, "") << " " << cumulative << "\n";
+            }
+        }
+    }
+}
@@ -0,0 +1,279 @@
+#ifndef METRICS_H
+#define METRICS_H
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @file Metrics.h
+ * @brief Defines the metrics registry and its counters, gauges and histograms.
+ *
+ * Every metric keeps one cache-line-aligned cell per thread slot. Each thread
+ * updates only its own slot, so instrumented code on different threads never
+ * contends for or falsely shares a cache line. The first METRIC_SLOTS - 1 threads
+ * own their slot outright and update it with a plain relaxed load and store, with
+ * no locked instruction, at a cost of a few nanoseconds. Later threads share the
+ * last slot and update it with an atomic add. Reads sum the slots and are only needed when
+ * metrics are exported.
+ *
+ * @see MetricsExporter
+ */
+
+/** Number of per-thread cells kept by every metric; the last is shared by any further threads. */
+constexpr int METRIC_SLOTS = 64;
+
+/** Assumed size of a cache line, in bytes. */
+constexpr int CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief Hands out thread slots in creation order.
+ *
+ * @return The next free slot, or the shared last slot once the others are taken.
+ */
+int next_metric_slot();
+
+/**
+ * @brief Gets the calling thread's slot.
+ *
+ * @return An index below METRIC_SLOTS, fixed for the life of the thread.
+ */
+inline int metric_slot() {
+    thread_local int slot = next_metric_slot();
+    return slot;
+}
+
+/**
+ * @brief Adds to a cell owned by the calling thread.
+ *
+ * @param cell The cell.
+ * @param slot The calling thread's slot; the last slot is shared.
+ * @param amount Amount to add.
+ */
+inline void add_to_cell(std::atomic<long long>& cell, int slot, long long amount) {
+    if (slot < METRIC_SLOTS - 1) {
+        cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    } else {
+        cell.fetch_add(amount, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @struct MetricCell
+ * @brief One thread's share of a counter or gauge, alone on its cache line.
+ */
+struct alignas(CACHE_LINE_SIZE) MetricCell {
+    std::atomic<long long> value{0};
+};
+
+/**
+ * @class Counter
+ * @brief A monotonically increasing count.
+ */
+class Counter {
+private:
+    MetricCell cells[METRIC_SLOTS];
+
+public:
+
+    /**
+     * @brief Adds to the count.
+     *
+     * @param amount Amount to add; must not be negative.
+     */
+    void inc(long long amount = 1) {
+        int slot = metric_slot();
+        add_to_cell(cells[slot].value, slot, amount);
+    }
+
+    /**
+     * @brief Gets the count summed over all threads.
+     *
+     * @return The count.
+     */
+    long long value() const;
+};
+
+/**
+ * @class Gauge
+ * @brief A value that can go up and down.
+ *
+ * Each thread owns its contribution and the gauge reports their sum, so balancers
+ * on different threads that share a gauge report their total. Code that shares a
+ * gauge on one thread should use add() with the change in its own value.
+ */
+class Gauge {
+private:
+    MetricCell cells[METRIC_SLOTS];
+
+public:
+
+    /**
+     * @brief Sets the calling thread's contribution.
+     *
+     * Threads sharing the last slot overwrite each other's contribution.
+     *
+     * @param value The new contribution.
+     */
+    void set(long long value) {
+        cells[metric_slot()].value.store(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Adds to the calling thread's contribution.
+     *
+     * @param amount Amount to add; may be negative.
+     */
+    void add(long long amount) {
+        int slot = metric_slot();
+        add_to_cell(cells[slot].value, slot, amount);
+    }
+
+    /**
+     * @brief Gets the value summed over all threads.
+     *
+     * @return The value.
+     */
+    long long value() const;
+};
+
+/**
+ * @class Histogram
+ * @brief A distribution of non-negative values in power-of-two buckets.
+ *
+ * Bucket i counts values up to 2^i; the last bucket counts everything larger.
+ */
+class Histogram {
+public:
+    /** Number of buckets, including the overflow bucket. */
+    static constexpr int BUCKETS = 24;
+
+private:
+
+    /**
+     * @brief One thread's bucket counts and sum, starting on its own cache line.
+     */
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<long long> counts[BUCKETS] = {};
+        std::atomic<long long> sum{0};
+    };
+
+    Slot slots[METRIC_SLOTS];
+
+public:
+
+    /**
+     * @brief Gets the bucket a value falls in.
+     *
+     * @param value The value.
+     * @return The smallest i with value <= 2^i, capped at the overflow bucket.
+     */
+    static int bucket_for(long long value) {
+        if (value <= 1) return 0;
+        int bucket = 64 - __builtin_clzll((unsigned long long) value - 1);
+        return bucket < BUCKETS - 1 ? bucket : BUCKETS - 1;
+    }
+
+    /**
+     * @brief Records one value.
+     *
+     * @param value The value; negative values count as 0.
+     */
+    void observe(long long value) {
+        int index = metric_slot();
+        Slot& slot = slots[index];
+        add_to_cell(slot.counts[bucket_for(value)], index, 1);
+        add_to_cell(slot.sum, index, value > 0 ? value : 0);
+    }
+
+    /**
+     * @brief Gets the number of values in each bucket, summed over all threads.
+     *
+     * @return One count per bucket.
+     */
+    std::vector<long long> bucket_counts() const;
+
+    /**
+     * @brief Gets the sum of every recorded value.
+     *
+     * @return The sum.
+     */
+    long long sum() const;
+};
+
+/**
+ * @class MetricsRegistry
+ * @brief Owns named metrics and renders them in the Prometheus text format.
+ *
+ * A metric is identified by its name and label set, written as in Prometheus
+ * (e.g. `shard="3"`). Asking for an existing metric returns the same instance, so
+ * several components can share one. Metrics live as long as the registry.
+ */
+class MetricsRegistry {
+private:
+    enum Type { COUNTER, GAUGE, HISTOGRAM };
+
+    /**
+     * @brief A registered metric.
+     */
+    struct Entry {
+        std::string name;
+        std::string labels;
+        std::string help;
+        Type type;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    std::mutex lock;
+    std::vector<std::unique_ptr<Entry>> entries;
+
+    /**
+     * @brief Finds or creates an entry; nullptr if the name is taken by another type.
+     */
+    Entry* find_or_add(const std::string& name, const std::string& help, const std::string& labels, Type type);
+
+public:
+
+    /**
+     * @brief Gets or creates a counter.
+     *
+     * @param name Metric name, e.g. "lb_requests_total".
+     * @param help One-line description.
+     * @param labels Label set without braces; empty for none.
+     * @return The counter, or nullptr if the name is registered as another type.
+     */
+    Counter* counter(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    /**
+     * @brief Gets or creates a gauge.
+     *
+     * @param name Metric name.
+     * @param help One-line description.
+     * @param labels Label set without braces; empty for none.
+     * @return The gauge, or nullptr if the name is registered as another type.
+     */
+    Gauge* gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    /**
+     * @brief Gets or creates a histogram.
+     *
+     * @param name Metric name.
+     * @param help One-line description.
+     * @param labels Label set without braces; empty for none.
+     * @return The histogram, or nullptr if the name is registered as another type.
+     */
+    Histogram* histogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    /**
+     * @brief Writes every metric in the Prometheus text exposition format.
+     *
+     * @param out Destination stream.
+     */
+    void write_prometheus(std::ostream& out);
+};
+
+#endif
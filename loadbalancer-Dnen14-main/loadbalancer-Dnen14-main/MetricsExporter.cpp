@@ -0,0 +1,157 @@
+/**
+ * @file MetricsExporter.cpp
+ * @brief Implementation of the MetricsExporter class.
+ *
+ * @see MetricsExporter
+ *
+ */
+
+#include "MetricsExporter.h"
+#include <arpa/inet.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** How often the background thread checks whether it should stop, in milliseconds. */
+static const int POLL_INTERVAL_MS = 100;
+
+bool write_metrics_file(MetricsRegistry& registry, const std::string& path) {
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        if (!out.is_open()) return false;
+        registry.write_prometheus(out);
+        out.flush();
+        if (!out) return false;
+    }
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+
+/**
+ * @brief Constructs an idle exporter.
+ *
+ * @param registry The metrics to publish.
+ */
+MetricsExporter::MetricsExporter(MetricsRegistry& registry)
+    : registry(registry), running(false), listenFd(-1), intervalMs(1000) {}
+
+/**
+ * @brief Stops the exporter.
+ */
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+/**
+ * @brief Starts serving metrics over HTTP on 127.0.0.1.
+ *
+ * @param port TCP port to listen on.
+ * @return true If the socket is listening.
+ */
+bool MetricsExporter::serve_http(int port) {
+    if (running) return false;
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) return false;
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listenFd, (sockaddr*) &address, sizeof(address)) != 0 || listen(listenFd, 8) != 0) {
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    running = true;
+    worker = std::thread([this] { serve_loop(); });
+    return true;
+}
+
+/**
+ * @brief Starts rewriting a snapshot file at a fixed interval.
+ *
+ * @param path Destination file.
+ * @param intervalMs Time between snapshots, in milliseconds.
+ * @return true If the writer started.
+ */
+bool MetricsExporter::write_periodically(const std::string& path, int intervalMs) {
+    if (running) return false;
+    this->path = path;
+    this->intervalMs = intervalMs > 0 ? intervalMs : 1000;
+    running = true;
+    worker = std::thread([this] { write_loop(); });
+    return true;
+}
+
+/**
+ * @brief Stops the background thread; a periodic file gets one final snapshot.
+ */
+void MetricsExporter::stop() {
+    if (!running) return;
+    running = false;
+    worker.join();
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+    }
+    if (!path.empty()) write_metrics_file(registry, path);
+}
+
+/**
+ * @brief Accept loop of the HTTP endpoint.
+ *
+ * Each connection gets one HTTP/1.1 response and is closed; the request itself is
+ * read and ignored.
+ */
+void MetricsExporter::serve_loop() {
+    while (running) {
+        pollfd listening = {listenFd, POLLIN, 0};
+        if (poll(&listening, 1, POLL_INTERVAL_MS) <= 0) continue;
+        int client = accept(listenFd, nullptr, nullptr);
+        if (client < 0) continue;
+
+        char request[1024];
+        pollfd readable = {client, POLLIN, 0};
+        if (poll(&readable, 1, POLL_INTERVAL_MS) > 0) {
+            ssize_t ignored = read(client, request, sizeof(request));
+            (void) ignored;
+        }
+
+        std::ostringstream body;
+        registry.write_prometheus(body);
+        std::string text = body.str();
+        std::string response = "HTTP/1.1 200 OK\r\n"
+                               "Content-Type: text/plain; version=0.0.4\r\n"
+                               "Content-Length: " + std::to_string(text.size()) + "\r\n"
+                               "Connection: close\r\n\r\n" + text;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t written = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (written <= 0) break;
+            sent += written;
+        }
+        close(client);
+    }
+}
+
+/**
+ * @brief Write loop of the snapshot file.
+ */
+void MetricsExporter::write_loop() {
+    auto next = std::chrono::steady_clock::now();
+    while (running) {
+        if (std::chrono::steady_clock::now() >= next) {
+            write_metrics_file(registry, path);
+            next += std::chrono::milliseconds(intervalMs);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::min(intervalMs, POLL_INTERVAL_MS)));
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+#include "Metrics.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * @file MetricsExporter.h
+ * @brief Defines the MetricsExporter class, which publishes a MetricsRegistry while a run is in progress.
+ */
+
+/**
+ * @brief Writes the registry to a file in the Prometheus text format.
+ *
+ * The file is written under a temporary name and renamed into place, so readers
+ * never see a partial snapshot.
+ *
+ * @param registry The metrics to write.
+ * @param path Destination file.
+ * @return True on success.
+ */
+bool write_metrics_file(MetricsRegistry& registry, const std::string& path);
+
+/**
+ * @class MetricsExporter
+ * @brief Publishes metrics from a background thread.
+ *
+ * Either serves the Prometheus text format over HTTP on a local port, for scraping
+ * or curl, or rewrites a snapshot file at a fixed interval. The simulation thread
+ * is never blocked by the exporter.
+ */
+class MetricsExporter {
+private:
+    MetricsRegistry& registry;
+    std::thread worker;
+    std::atomic<bool> running;
+    int listenFd;
+    std::string path;
+    int intervalMs;
+
+    /**
+     * @brief Accept loop of the HTTP endpoint.
+     */
+    void serve_loop();
+
+    /**
+     * @brief Write loop of the snapshot file.
+     */
+    void write_loop();
+
+public:
+
+    /**
+     * @brief Constructs an idle exporter.
+     *
+     * @param registry The metrics to publish; must outlive the exporter.
+     */
+    explicit MetricsExporter(MetricsRegistry& registry);
+
+    /**
+     * @brief Stops the exporter.
+     */
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /**
+     * @brief Starts serving metrics over HTTP on 127.0.0.1.
+     *
+     * Every request, whatever its path, is answered with the full registry.
+     *
+     * @param port TCP port to listen on.
+     * @return True if the socket is listening; false if it could not be opened or the exporter is already running.
+     */
+    bool serve_http(int port);
+
+    /**
+     * @brief Starts rewriting a snapshot file at a fixed interval.
+     *
+     * @param path Destination file.
+     * @param intervalMs Time between snapshots, in milliseconds.
+     * @return False if the exporter is already running.
+     */
+    bool write_periodically(const std::string& path, int intervalMs);
+
+    /**
+     * @brief Stops the background thread; a periodic file gets one final snapshot.
+     */
+    void stop();
+};
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ * @file Random.cpp
+ * @brief Implementation of the Rng class (xoshiro256** by Blackman and Vigna).
+ *
+ * @see Rng
+ *
+ */
+
+#include "Random.h"
+#include "utils.h"
+#include <cmath>
+
+/** Pi to double precision, for the Box-Muller transform. */
+static const double PI = 3.14159265358979323846;
+
+/**
+ * @brief Advances a splitmix64 state and returns its next output.
+ *
+ * Used only to expand a 64-bit seed into the 256-bit xoshiro state.
+ *
+ * @param x The splitmix64 state.
+ * @return uint64_t The next output.
+ */
+static uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Rotates a 64-bit value left.
+ */
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief Constructs a generator from a seed.
+ *
+ * @param seed Any 64-bit value.
+ */
+Rng::Rng(uint64_t seed) {
+    this->seed(seed);
+}
+
+/**
+ * @brief Re-seeds the generator.
+ *
+ * @param seed Any 64-bit value.
+ */
+void Rng::seed(uint64_t seed) {
+    for (int i = 0; i < 4; ++i) {
+        state[i] = splitmix64(seed);
+    }
+}
+
+/**
+ * @brief Returns the next 64 random bits.
+ *
+ * @return uint64_t A uniformly distributed 64-bit value.
+ */
+uint64_t Rng::next() {
+    uint64_t result = rotl(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+}
+
+/**
+ * @brief Returns a uniform double in (0, 1).
+ *
+ * Uses the top 53 bits and offsets by half a step so 0 is never produced.
+ *
+ * @return double A uniformly distributed double.
+ */
+double Rng::uniform() {
+    return ((next() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Returns a uniform integer in [low, high].
+ *
+ * @param low Smallest value.
+ * @param high Largest value.
+ * @return int A uniformly distributed integer.
+ */
+int Rng::uniform_int(int low, int high) {
+    if (high <= low) return low;
+    uint64_t range = (uint64_t) ((int64_t) high - low) + 1;
+    return (int) (low + (int64_t) (next() % range));
+}
+
+/**
+ * @brief Returns true with the given probability.
+ *
+ * @param probability Chance of returning true, in [0, 1].
+ * @return bool The outcome of the trial.
+ */
+bool Rng::bernoulli(double probability) {
+    return uniform() < probability;
+}
+
+/**
+ * @brief Returns a standard normal sample using the Box-Muller transform.
+ *
+ * @return double A normally distributed double with mean 0 and variance 1.
+ */
+double Rng::normal() {
+    double u1 = uniform();
+    double u2 = uniform();
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * PI * u2);
+}
+
+/**
+ * @brief Writes the generator state to a binary snapshot.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void Rng::save(std::ostream& out) const {
+    for (int i = 0; i < 4; ++i) write_value(out, state[i]);
+}
+
+/**
+ * @brief Restores state written by save().
+ *
+ * @param in Stream opened in binary mode.
+ * @return true On success.
+ */
+bool Rng::restore(std::istream& in) {
+    for (int i = 0; i < 4; ++i) {
+        if (!read_value(in, state[i])) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Derives an independent seed for one component from a master seed.
+ *
+ * @param seed The master seed.
+ * @param stream A distinct number per component.
+ * @return uint64_t The component's seed.
+ */
+uint64_t derive_seed(uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ (stream * 0xd1b54a32d192ed03ULL);
+    return splitmix64(x);
+}
@@ -14,9 +14,11 @@
  */
 
 #include "Request.h"
+#include "utils.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <cctype>
 
 /**
  * @class Request
@@ -78,6 +80,75 @@ void Request::set_body(const string& body) {
     this->body = body;
 }
 
+/**
+ * @brief Gets the HTTP method of the request.
+ *
+ * @return const string& The HTTP method.
+ */
+const string& Request::get_method() const {
+    return method;
+}
+
+/**
+ * @brief Gets the URL of the request.
+ *
+ * @return const string& The request URL.
+ */
+const string& Request::get_url() const {
+    return url;
+}
+
+/**
+ * @brief Gets the raw headers of the request.
+ *
+ * @return const string& The headers, one "Name: value" pair per line.
+ */
+const string& Request::get_headers() const {
+    return headers;
+}
+
+/**
+ * @brief Gets the body content of the request.
+ *
+ * @return const string& The request body.
+ */
+const string& Request::get_body() const {
+    return body;
+}
+
+/**
+ * @brief Looks up a single header value.
+ *
+ * Scans the newline-separated header block for a line whose name matches
+ * case-insensitively and returns its value with surrounding whitespace removed.
+ *
+ * @param name The header name, without the colon.
+ * @return string The header value, or an empty string if the header is absent.
+ */
+string Request::get_header(const string& name) const {
+    size_t lineStart = 0;
+    while (lineStart < headers.size()) {
+        size_t lineEnd = headers.find('\n', lineStart);
+        if (lineEnd == string::npos) lineEnd = headers.size();
+        size_t colon = headers.find(':', lineStart);
+        if (colon != string::npos && colon < lineEnd && colon - lineStart == name.size()) {
+            bool match = true;
+            for (size_t i = 0; i < name.size() && match; ++i) {
+                match = std::tolower((unsigned char) headers[lineStart + i]) == std::tolower((unsigned char) name[i]);
+            }
+            if (match) {
+                size_t valueStart = colon + 1;
+                while (valueStart < lineEnd && std::isspace((unsigned char) headers[valueStart])) valueStart++;
+                size_t valueEnd = lineEnd;
+                while (valueEnd > valueStart && std::isspace((unsigned char) headers[valueEnd - 1])) valueEnd--;
+                return headers.substr(valueStart, valueEnd - valueStart);
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+    return "";
+}
+
 /**
  * @brief Prints the details of the request to the console.
  * 
@@ -89,9 +160,27 @@ void Request::print_request() const {
 /**
  * @brief decrement the task time by 1 cycle.
  * 
+ * Also counts the cycle as served.
  */
 void Request::decrement_task_time() {
     if (taskTime > 0) taskTime--;
+    servedCycles++;
+}
+
+/**
+ * @brief Serves the request for one cycle on a server of the given speed.
+ *
+ * Whole units of accumulated work are taken off the task time; the remainder is
+ * kept for the next cycle. Counts the cycle as served.
+ *
+ * @param speed Work done this cycle, in standard-server cycles.
+ */
+void Request::do_work(double speed) {
+    servedCycles++;
+    workCredit += speed;
+    int whole = (int) workCredit;
+    workCredit -= whole;
+    taskTime = whole >= taskTime ? 0 : taskTime - whole;
 }
 
 /**
@@ -118,3 +207,129 @@ int Request::get_task_time() const {
     return taskTime;
 }
 
+/**
+ * @brief Sets the size of the response to this request.
+ *
+ * @param bytes Response size in bytes.
+ */
+void Request::set_size(long long bytes){
+    size = bytes;
+}
+
+/**
+ * @brief Gets the size of the response to this request.
+ *
+ * @return long long Response size in bytes, or 0 if unknown.
+ */
+long long Request::get_size() const {
+    return size;
+}
+
+/**
+ * @brief Sets the cycle at which the request entered the LoadBalancer.
+ *
+ * @param cycle The arrival cycle.
+ */
+void Request::set_arrival_cycle(int cycle){
+    arrivalCycle = cycle;
+}
+
+/**
+ * @brief Gets the cycle at which the request entered the LoadBalancer.
+ *
+ * @return int The arrival cycle.
+ */
+int Request::get_arrival_cycle() const {
+    return arrivalCycle;
+}
+
+/**
+ * @brief Sets the cycle by which the request must complete.
+ *
+ * @param cycle The deadline, or -1 for none.
+ */
+void Request::set_deadline(int cycle){
+    deadline = cycle;
+}
+
+/**
+ * @brief Gets the cycle by which the request must complete.
+ *
+ * @return int The deadline, or -1 if the request has none.
+ */
+int Request::get_deadline() const {
+    return deadline;
+}
+
+/**
+ * @brief Checks whether the client has given up on the request.
+ *
+ * A request may still be served in its deadline cycle.
+ *
+ * @param now The current simulation cycle.
+ * @return true If the request has a deadline and it has passed.
+ */
+bool Request::is_expired(int now) const {
+    return deadline >= 0 && now > deadline;
+}
+
+/**
+ * @brief Gets the number of cycles a server has spent on the request.
+ *
+ * @return int Served cycles.
+ */
+int Request::get_served_cycles() const {
+    return servedCycles;
+}
+
+/**
+ * @brief Marks the request as caught by a scale-down.
+ *
+ * The mark survives a hand-off back to the queue.
+ *
+ * @param drained True if the request was in flight on a server that started draining.
+ */
+void Request::set_drained(bool drained){
+    this->drained = drained;
+}
+
+/**
+ * @brief Checks whether the request was caught by a scale-down.
+ *
+ * @return bool True if the request was in flight on a server that started draining.
+ */
+bool Request::is_drained() const {
+    return drained;
+}
+
+/**
+ * @brief Writes the request to a binary snapshot.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void Request::save(std::ostream& out) const {
+    write_string(out, method);
+    write_string(out, url);
+    write_string(out, headers);
+    write_string(out, body);
+    write_value(out, taskTime);
+    write_value(out, size);
+    write_value(out, arrivalCycle);
+    write_value(out, deadline);
+    write_value(out, servedCycles);
+    write_value(out, workCredit);
+    write_value(out, drained);
+}
+
+/**
+ * @brief Restores a request written by save().
+ *
+ * @param in Stream opened in binary mode.
+ * @return true On success.
+ */
+bool Request::restore(std::istream& in) {
+    return read_string(in, method) && read_string(in, url) && read_string(in, headers)
+        && read_string(in, body) && read_value(in, taskTime) && read_value(in, size)
+        && read_value(in, arrivalCycle) && read_value(in, deadline) && read_value(in, servedCycles)
+        && read_value(in, workCredit) && read_value(in, drained);
+}
@@ -14,7 +14,11 @@
 #ifndef REQUEST_H
 #define REQUEST_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <istream>
+#include <ostream>
 using std::string;
 
 class Request {
@@ -24,8 +28,18 @@ private:
     string headers;
     string body;
     int taskTime = 0;
+    long long size = 0;
+    int arrivalCycle = 0;
+    int deadline = -1;
+    int servedCycles = 0;
+    double workCredit = 0.0;
+    bool drained = false;
 
 public:
+    /** Fewest bytes save() writes: four empty strings and the fixed-size fields. */
+    static constexpr size_t MIN_SNAPSHOT_BYTES =
+        4 * sizeof(uint32_t) + 4 * sizeof(int) + sizeof(long long) + sizeof(double) + sizeof(bool);
+
     /**
      * @brief Default constructor for Request.
      * 
@@ -68,6 +82,44 @@ public:
      */
     void set_body(const string& body);
 
+    /**
+     * @brief Gets the HTTP method of the request.
+     *
+     * @return The HTTP method (e.g., GET, POST).
+     */
+    const string& get_method() const;
+
+    /**
+     * @brief Gets the URL of the request.
+     *
+     * @return The request URL.
+     */
+    const string& get_url() const;
+
+    /**
+     * @brief Gets the raw headers of the request.
+     *
+     * @return The headers, one "Name: value" pair per line.
+     */
+    const string& get_headers() const;
+
+    /**
+     * @brief Gets the body content of the request.
+     *
+     * @return The request body.
+     */
+    const string& get_body() const;
+
+    /**
+     * @brief Looks up a single header value.
+     *
+     * Header names are matched case-insensitively.
+     *
+     * @param name The header name, without the colon.
+     * @return The trimmed header value, or an empty string if the header is absent.
+     */
+    string get_header(const string& name) const;
+
     /**
      * @brief Prints the details of the request.
      * 
@@ -81,6 +133,17 @@ public:
      */
     void decrement_task_time();
 
+    /**
+     * @brief Serves the request for one cycle on a server of the given speed.
+     *
+     * Task time is measured in cycles of a standard (speed 1) server, so a faster
+     * server removes more than one cycle of it and a slower one may need several
+     * cycles per unit; fractions carry over to the next cycle.
+     *
+     * @param speed Work done this cycle, in standard-server cycles.
+     */
+    void do_work(double speed);
+
     /**
      * @brief check if the request is completed
      * 
@@ -98,6 +161,92 @@ public:
      * @brief Gets task time for the request.
      */
     int get_task_time() const;
+
+    /**
+     * @brief Sets the size of the response to this request.
+     *
+     * @param bytes Response size in bytes.
+     */
+    void set_size(long long bytes);
+
+    /**
+     * @brief Gets the size of the response to this request.
+     *
+     * @return Response size in bytes, or 0 if unknown.
+     */
+    long long get_size() const;
+
+    /**
+     * @brief Sets the cycle at which the request entered the LoadBalancer.
+     *
+     * @param cycle The arrival cycle.
+     */
+    void set_arrival_cycle(int cycle);
+
+    /**
+     * @brief Gets the cycle at which the request entered the LoadBalancer.
+     *
+     * @return The arrival cycle.
+     */
+    int get_arrival_cycle() const;
+
+    /**
+     * @brief Sets the cycle by which the request must complete.
+     *
+     * @param cycle The deadline, or -1 for none.
+     */
+    void set_deadline(int cycle);
+
+    /**
+     * @brief Gets the cycle by which the request must complete.
+     *
+     * @return The deadline, or -1 if the request has none.
+     */
+    int get_deadline() const;
+
+    /**
+     * @brief Checks whether the client has given up on the request.
+     *
+     * @param now The current simulation cycle.
+     * @return True if the request has a deadline and it has passed.
+     */
+    bool is_expired(int now) const;
+
+    /**
+     * @brief Gets the number of cycles a server has spent on the request.
+     *
+     * @return Served cycles.
+     */
+    int get_served_cycles() const;
+
+    /**
+     * @brief Marks the request as caught by a scale-down.
+     *
+     * @param drained True if the request was in flight on a server that started draining.
+     */
+    void set_drained(bool drained);
+
+    /**
+     * @brief Checks whether the request was caught by a scale-down.
+     *
+     * @return True if the request was in flight on a server that started draining.
+     */
+    bool is_drained() const;
+
+    /**
+     * @brief Writes the request to a binary snapshot.
+     *
+     * @param out Stream opened in binary mode.
+     */
+    void save(std::ostream& out) const;
+
+    /**
+     * @brief Restores a request written by save().
+     *
+     * @param in Stream opened in binary mode.
+     * @return True on success.
+     */
+    bool restore(std::istream& in);
 };
 
 #endif
@@ -16,6 +16,10 @@
 
 #include "RequestQueue.h"
 #include "Request.h"
+#include "Tracing.h"
+#include "utils.h"
+#include <algorithm>
+#include <climits>
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -35,7 +39,7 @@
  * 
  * Initializes an empty request queue.
  */
-RequestQueue::RequestQueue() {}
+RequestQueue::RequestQueue() : maxProcessingDelay(50), order(QueueOrder::FIFO) {}
 
 /**
  * @brief Destructor for RequestQueue.
@@ -44,35 +48,98 @@ RequestQueue::RequestQueue() {}
  */
 RequestQueue::~RequestQueue() {}
 
+/**
+ * @brief Sort key for EDF order: the deadline, with requests that have none last.
+ */
+static int edf_key(const Request& request) {
+    int deadline = request.get_deadline();
+    return deadline < 0 ? INT_MAX : deadline;
+}
+
 /**
  * @brief Adds a new request to the queue.
  * 
+ * In EDF order the queue is kept sorted by deadline and the request is placed
+ * after every request with the same or an earlier deadline. Deadlines usually
+ * grow with arrival time, so this is normally a binary search and an append.
+ * 
  * @param request The request object to be added to the queue.
+ * @return Request& The queued copy of the request.
+ */
+Request& RequestQueue::add_request(const Request& request) {
+    TraceSpan span("RequestQueue::add_request");
+    if (order == QueueOrder::EDF && request.get_deadline() >= 0) {
+        auto position = std::upper_bound(requestQueue.begin(), requestQueue.end(), edf_key(request),
+                                         [](int key, const Request& queued) { return key < edf_key(queued); });
+        return *requestQueue.insert(position, request);
+    }
+    requestQueue.push_back(request);
+    return requestQueue.back();
+}
+
+/**
+ * @brief Puts back a request a server could not finish, ahead of new arrivals.
+ *
+ * @param request The request to requeue.
  */
-void RequestQueue::add_request(const Request& request) {
-    requestQueue.push(request);
+void RequestQueue::requeue_request(const Request& request) {
+    if (order == QueueOrder::EDF) {
+        auto position = std::lower_bound(requestQueue.begin(), requestQueue.end(), edf_key(request),
+                                         [](const Request& queued, int key) { return edf_key(queued) < key; });
+        requestQueue.insert(position, request);
+        return;
+    }
+    requestQueue.push_front(request);
 }
 
 /**
  * @brief Processes the next request in the queue.
  * 
- * Removes the front request from the queue if it's not empty.
+ * Sleeps for a random delay of up to maxProcessingDelay milliseconds to simulate
+ * handling, then removes the front request from the queue if it's not empty. The
+ * delay is drawn from the queue's own seeded Rng.
  */
 void RequestQueue::process_next_request() {
-    std::this_thread::sleep_for(std::chrono::milliseconds(rand() % (50 - 1 + 1) + 1));
+    TraceSpan span("RequestQueue::process_next_request");
+    if (maxProcessingDelay > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(rng.uniform_int(1, maxProcessingDelay)));
+    }
 
     if (!(requestQueue.empty())) {
-        requestQueue.pop();
+        requestQueue.pop_front();
     }
 }
 
+/**
+ * @brief Takes up to a number of requests from the front of the queue in one call.
+ *
+ * Sleeps once, like process_next_request(), for the whole batch, then moves the
+ * requests out of the queue; the batch vector's storage is reused across calls.
+ *
+ * @param maxRequests Largest number of requests to take.
+ * @param batch Cleared, then filled with the requests in queue order.
+ * @return int The number of requests taken.
+ */
+int RequestQueue::take_requests(int maxRequests, std::vector<Request>& batch) {
+    TraceSpan span("RequestQueue::take_requests");
+    batch.clear();
+    int taken = std::min<int>(maxRequests, requestQueue.size());
+    if (taken <= 0) return 0;
+    if (maxProcessingDelay > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(rng.uniform_int(1, maxProcessingDelay)));
+    }
+    std::move(requestQueue.begin(), requestQueue.begin() + taken, std::back_inserter(batch));
+    requestQueue.erase(requestQueue.begin(), requestQueue.begin() + taken);
+    return taken;
+}
+
 /**
  * @brief Removes a request from the queue.
  * 
  * Directly removes the front request from the queue without processing it.
  */
 void RequestQueue::remove_request(){
-    requestQueue.pop();
+    requestQueue.pop_front();
 }
 
 /**
@@ -100,3 +167,79 @@ int RequestQueue::get_size() const {
 Request& RequestQueue::get_front_request() {
     return requestQueue.front();
 }
+
+/**
+ * @brief Sets the order in which requests are served.
+ *
+ * @param order FIFO or EDF.
+ */
+void RequestQueue::set_order(QueueOrder order) {
+    this->order = order;
+    if (order == QueueOrder::EDF) {
+        std::stable_sort(requestQueue.begin(), requestQueue.end(),
+                         [](const Request& a, const Request& b) { return edf_key(a) < edf_key(b); });
+    }
+}
+
+/**
+ * @brief Gets the order in which requests are served.
+ *
+ * @return QueueOrder The queue order.
+ */
+QueueOrder RequestQueue::get_order() const {
+    return order;
+}
+
+/**
+ * @brief Seeds the random source used for the simulated processing delay.
+ *
+ * @param seed Any 64-bit value.
+ */
+void RequestQueue::seed(uint64_t seed) {
+    rng.seed(seed);
+}
+
+/**
+ * @brief Sets the longest simulated processing delay.
+ *
+ * @param milliseconds Upper bound of the delay; 0 disables it.
+ */
+void RequestQueue::set_max_processing_delay(int milliseconds) {
+    maxProcessingDelay = milliseconds;
+}
+
+/**
+ * @brief Writes the queued requests and random state to a binary snapshot.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void RequestQueue::save(std::ostream& out) const {
+    rng.save(out);
+    write_value(out, maxProcessingDelay);
+    write_value(out, order);
+    write_value<uint64_t>(out, requestQueue.size());
+    for (const Request& request : requestQueue) {
+        request.save(out);
+    }
+}
+
+/**
+ * @brief Replaces the queue's contents with a snapshot written by save().
+ *
+ * @param in Stream opened in binary mode.
+ * @return true On success.
+ */
+bool RequestQueue::restore(std::istream& in) {
+    uint64_t size = 0;
+    if (!rng.restore(in) || !read_value(in, maxProcessingDelay) || !read_value(in, order) || !read_value(in, size)
+        || (order != QueueOrder::FIFO && order != QueueOrder::EDF)) {
+        return false;
+    }
+    requestQueue.clear();
+    for (uint64_t i = 0; i < size; ++i) {
+        Request request;
+        if (!request.restore(in)) return false;
+        requestQueue.push_back(request);
+    }
+    return true;
+}
@@ -1,8 +1,12 @@
 #ifndef REQUEST_QUEUE_H
 #define REQUEST_QUEUE_H
 #include "Request.h"
-#include <queue>
-using std::queue;
+#include "Random.h"
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <vector>
+using std::deque;
 
 /**
  * @file RequestQueue.h
@@ -12,6 +16,15 @@ using std::queue;
  * providing methods to add, remove, process, and query requests in the queue.
  */
 
+/**
+ * @brief Order in which queued requests are served.
+ *
+ * FIFO serves requests in arrival order. EDF (earliest deadline first) serves the
+ * request with the nearest deadline; requests without a deadline go after every
+ * request that has one, in arrival order.
+ */
+enum class QueueOrder { FIFO, EDF };
+
 /**
  * @class RequestQueue
  * @brief A class that manages a queue of HTTP requests.
@@ -26,7 +39,22 @@ private:
     /**
      * @brief A queue to hold Request objects.
      */
-    queue<Request> requestQueue;
+    deque<Request> requestQueue;
+
+    /**
+     * @brief Random source for the simulated processing delay.
+     */
+    Rng rng;
+
+    /**
+     * @brief Longest simulated processing delay, in milliseconds.
+     */
+    int maxProcessingDelay;
+
+    /**
+     * @brief Order in which requests are served.
+     */
+    QueueOrder order;
 
 public:
 
@@ -45,15 +73,40 @@ public:
     /**
      * @brief Adds a new request to the queue.
      * 
+     * In EDF order the request is inserted by deadline, and may go ahead of a
+     * partly served request at the front (preemptive EDF).
+     * 
      * @param request The Request object to be added to the queue.
+     * @return The queued copy of the request.
      */
-    void add_request(const Request& request);
+    Request& add_request(const Request& request);
+
+    /**
+     * @brief Puts back a request a server could not finish, ahead of new arrivals.
+     *
+     * In FIFO order the request goes to the front; in EDF order it goes before
+     * every request with the same or a later deadline.
+     *
+     * @param request The request to requeue.
+     */
+    void requeue_request(const Request& request);
 
     /**
      * @brief Removes the front request from the queue.
      */
     void remove_request();
 
+    /**
+     * @brief Takes up to a number of requests from the front of the queue in one call.
+     *
+     * The simulated processing delay is paid once for the whole batch.
+     *
+     * @param maxRequests Largest number of requests to take.
+     * @param batch Cleared, then filled with the requests in queue order.
+     * @return The number of requests taken.
+     */
+    int take_requests(int maxRequests, std::vector<Request>& batch);
+
     /**
      * @brief Processes the next request in the queue.
      * 
@@ -79,6 +132,51 @@ public:
      * @brief returns a reference
      */
     Request& get_front_request();
+
+    /**
+     * @brief Sets the order in which requests are served.
+     *
+     * Requests already queued are reordered.
+     *
+     * @param order FIFO (the default) or EDF.
+     */
+    void set_order(QueueOrder order);
+
+    /**
+     * @brief Gets the order in which requests are served.
+     *
+     * @return The queue order.
+     */
+    QueueOrder get_order() const;
+
+    /**
+     * @brief Seeds the random source used for the simulated processing delay.
+     *
+     * @param seed Any 64-bit value.
+     */
+    void seed(uint64_t seed);
+
+    /**
+     * @brief Sets the longest simulated processing delay.
+     *
+     * @param milliseconds Upper bound of the delay; 0 disables it.
+     */
+    void set_max_processing_delay(int milliseconds);
+
+    /**
+     * @brief Writes the queued requests and random state to a binary snapshot.
+     *
+     * @param out Stream opened in binary mode.
+     */
+    void save(std::ostream& out) const;
+
+    /**
+     * @brief Replaces the queue's contents with a snapshot written by save().
+     *
+     * @param in Stream opened in binary mode.
+     * @return True on success.
+     */
+    bool restore(std::istream& in);
 };
 
 #endif
@@ -0,0 +1,228 @@
+/**
+ * @file ResponseCache.cpp
+ * @brief Implementation of the ResponseCache class for caching GET responses in the balancer.
+ *
+ * Each shard keeps its entries in a list ordered from most to least recently used and
+ * an index from key to list position, so lookups, inserts and evictions are all O(1).
+ * Expired entries are dropped lazily when they are looked up or reach the tail of
+ * the list.
+ *
+ * @see ResponseCache
+ * @see Request
+ *
+ */
+
+#include "ResponseCache.h"
+#include "utils.h"
+
+/** Fixed bookkeeping cost charged per entry on top of its key and payload. */
+static const size_t ENTRY_OVERHEAD = sizeof(void*) * 8;
+
+/**
+ * @brief Constructs a ResponseCache.
+ *
+ * @param shardCount Number of independently locked shards (at least one).
+ * @param memoryBudget Total bytes the cache may hold across all shards.
+ * @param ttl Time-to-live of an entry, in cycles.
+ */
+ResponseCache::ResponseCache(int shardCount, size_t memoryBudget, int ttl)
+    : ttl(ttl), hits(0), misses(0) {
+    if (shardCount < 1) shardCount = 1;
+    for (int i = 0; i < shardCount; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+    shardBudget = memoryBudget / shardCount;
+}
+
+/**
+ * @brief Picks the shard responsible for a key.
+ *
+ * @param key The cache key.
+ * @return Shard& The owning shard.
+ */
+ResponseCache::Shard& ResponseCache::shard_for(const string& key) {
+    return *shards[fnv1a_hash(key) % shards.size()];
+}
+
+/**
+ * @brief Builds the cache key for a request from its method and URL.
+ *
+ * @param request The request.
+ * @return string The cache key.
+ */
+string ResponseCache::make_key(const Request& request) {
+    return request.get_method() + " " + request.get_url();
+}
+
+/**
+ * @brief Checks whether a request may be served from the cache.
+ *
+ * Only GET requests are idempotent enough to be answered without a backend.
+ *
+ * @param request The request to check.
+ * @return true For GET requests.
+ */
+bool ResponseCache::is_cacheable(const Request& request) {
+    return request.get_method() == "GET";
+}
+
+/**
+ * @brief Looks up a response and moves it to the front of its shard's LRU list.
+ *
+ * @param request The request to look up.
+ * @param now The current simulation cycle.
+ * @return true If a live response was found.
+ */
+bool ResponseCache::lookup(const Request& request, int now) {
+    string key = make_key(request);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses++;
+        return false;
+    }
+    if (it->second->expiresAt <= now) {
+        shard.bytes -= it->second->bytes;
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        misses++;
+        return false;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    hits++;
+    return true;
+}
+
+/**
+ * @brief Stores the response to a completed request.
+ *
+ * The entry is charged for its key, the response size (or the request body when the
+ * size is unknown) and a fixed overhead. Least recently used entries are evicted
+ * until the shard is back within its budget; an entry larger than a whole shard is
+ * not stored.
+ *
+ * @param request The completed request.
+ * @param now The current simulation cycle.
+ */
+void ResponseCache::insert(const Request& request, int now) {
+    string key = make_key(request);
+    size_t payload = request.get_size() > 0 ? (size_t) request.get_size() : request.get_body().size();
+    size_t bytes = key.size() * 2 + payload + ENTRY_OVERHEAD;
+    if (bytes > shardBudget) return;
+
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        shard.bytes -= it->second->bytes;
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+    while (shard.bytes + bytes > shardBudget && !shard.lru.empty()) {
+        Entry& victim = shard.lru.back();
+        shard.bytes -= victim.bytes;
+        shard.index.erase(victim.key);
+        shard.lru.pop_back();
+    }
+    shard.lru.push_front(Entry{key, bytes, now + ttl});
+    shard.index[key] = shard.lru.begin();
+    shard.bytes += bytes;
+}
+
+/**
+ * @brief Gets the number of cache hits.
+ *
+ * @return long long Hit count.
+ */
+long long ResponseCache::get_hits() const {
+    return hits;
+}
+
+/**
+ * @brief Gets the number of cache misses.
+ *
+ * @return long long Miss count.
+ */
+long long ResponseCache::get_misses() const {
+    return misses;
+}
+
+/**
+ * @brief Gets the number of bytes currently held.
+ *
+ * @return size_t Bytes used across all shards.
+ */
+size_t ResponseCache::get_bytes() {
+    size_t total = 0;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> guard(shard->lock);
+        total += shard->bytes;
+    }
+    return total;
+}
+
+/**
+ * @brief Writes the configuration, counters and every entry to a binary snapshot.
+ *
+ * Entries are written from least to most recently used so restore() can rebuild
+ * each shard's LRU order by pushing them to the front in turn.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void ResponseCache::save(std::ostream& out) {
+    write_value<uint32_t>(out, shards.size());
+    write_value(out, shardBudget);
+    write_value(out, ttl);
+    write_value<long long>(out, hits);
+    write_value<long long>(out, misses);
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> guard(shard->lock);
+        write_value<uint64_t>(out, shard->lru.size());
+        for (auto it = shard->lru.rbegin(); it != shard->lru.rend(); ++it) {
+            write_string(out, it->key);
+            write_value(out, it->bytes);
+            write_value(out, it->expiresAt);
+        }
+    }
+}
+
+/**
+ * @brief Replaces the cache's contents with a snapshot written by save().
+ *
+ * Not safe to call while other threads are using the cache.
+ *
+ * @param in Stream opened in binary mode.
+ * @return true On success.
+ */
+bool ResponseCache::restore(std::istream& in) {
+    uint32_t shardCount = 0;
+    long long savedHits = 0;
+    long long savedMisses = 0;
+    if (!read_value(in, shardCount) || shardCount == 0 || !read_value(in, shardBudget)
+        || !read_value(in, ttl) || !read_value(in, savedHits) || !read_value(in, savedMisses)) {
+        return false;
+    }
+    hits = savedHits;
+    misses = savedMisses;
+
+    shards.clear();
+    for (uint32_t i = 0; i < shardCount; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+        Shard& shard = *shards.back();
+        uint64_t entries = 0;
+        if (!read_value(in, entries)) return false;
+        for (uint64_t e = 0; e < entries; ++e) {
+            Entry entry;
+            if (!read_string(in, entry.key) || !read_value(in, entry.bytes) || !read_value(in, entry.expiresAt)) {
+                return false;
+            }
+            shard.lru.push_front(entry);
+            shard.index[entry.key] = shard.lru.begin();
+            shard.bytes += entry.bytes;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,137 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+#include "Request.h"
+#include <atomic>
+#include <istream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file ResponseCache.h
+ * @brief Defines the ResponseCache class, an in-balancer cache for idempotent GET requests.
+ *
+ * Responses are keyed on method and URL and stored in a number of independently
+ * locked shards, each evicting in least-recently-used order. Entries expire after a
+ * fixed time-to-live and the cache as a whole stays within a memory budget.
+ */
+
+/**
+ * @class ResponseCache
+ * @brief A sharded, thread-safe LRU cache with TTLs and a memory budget.
+ *
+ * Every shard owns an equal slice of the memory budget and its own mutex, so
+ * lookups for different keys rarely contend. Times are simulation cycles.
+ */
+class ResponseCache {
+private:
+
+    /**
+     * @brief A cached response.
+     */
+    struct Entry {
+        string key;
+        size_t bytes;
+        int expiresAt;
+    };
+
+    /**
+     * @brief One independently locked slice of the cache.
+     */
+    struct Shard {
+        std::mutex lock;
+        std::list<Entry> lru;
+        std::unordered_map<string, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardBudget;
+    int ttl;
+    std::atomic<long long> hits;
+    std::atomic<long long> misses;
+
+    /**
+     * @brief Picks the shard responsible for a key.
+     */
+    Shard& shard_for(const string& key);
+
+    /**
+     * @brief Builds the cache key for a request.
+     */
+    static string make_key(const Request& request);
+
+public:
+
+    /**
+     * @brief Constructs a ResponseCache.
+     *
+     * @param shardCount Number of independently locked shards.
+     * @param memoryBudget Total bytes the cache may hold across all shards.
+     * @param ttl Time-to-live of an entry, in cycles.
+     */
+    ResponseCache(int shardCount, size_t memoryBudget, int ttl);
+
+    /**
+     * @brief Checks whether a request may be served from the cache.
+     *
+     * @param request The request to check.
+     * @return True for GET requests.
+     */
+    static bool is_cacheable(const Request& request);
+
+    /**
+     * @brief Looks up a response and refreshes its recency on a hit.
+     *
+     * @param request The request to look up.
+     * @param now The current simulation cycle.
+     * @return True if a live response was found.
+     */
+    bool lookup(const Request& request, int now);
+
+    /**
+     * @brief Stores the response to a completed request.
+     *
+     * @param request The completed request.
+     * @param now The current simulation cycle.
+     */
+    void insert(const Request& request, int now);
+
+    /**
+     * @brief Gets the number of cache hits.
+     * @return Hit count.
+     */
+    long long get_hits() const;
+
+    /**
+     * @brief Gets the number of cache misses.
+     * @return Miss count.
+     */
+    long long get_misses() const;
+
+    /**
+     * @brief Gets the number of bytes currently held.
+     * @return Bytes used across all shards.
+     */
+    size_t get_bytes();
+
+    /**
+     * @brief Writes the configuration, counters and every entry to a binary snapshot.
+     *
+     * @param out Stream opened in binary mode.
+     */
+    void save(std::ostream& out);
+
+    /**
+     * @brief Replaces the cache's contents with a snapshot written by save().
+     *
+     * @param in Stream opened in binary mode.
+     * @return True on success.
+     */
+    bool restore(std::istream& in);
+};
+
+#endif
@@ -0,0 +1,321 @@
+/**
+ * @file ShardedBalancer.cpp
+ * @brief Implementation of the ShardedBalancer class.
+ *
+ * @see ShardedBalancer
+ *
+ */
+
+#include "ShardedBalancer.h"
+#include "Random.h"
+#include "utils.h"
+
+/**
+ * @brief Constructs the tier and starts one thread per shard.
+ *
+ * @param shardCount Number of balancer shards.
+ * @param maxServers Maximum servers per shard.
+ * @param spillThreshold Queue length at which a shard spills to its neighbour; 0 disables spillover.
+ */
+ShardedBalancer::ShardedBalancer(int shardCount, int maxServers, int spillThreshold)
+    : spillThreshold(spillThreshold), count(0) {
+    if (shardCount < 1) shardCount = 1;
+    for (int i = 0; i < shardCount; ++i) {
+        shards.push_back(std::make_unique<Shard>(i, 8080 + i * maxServers, maxServers));
+        shards.back()->balancer.set_verbose(false);
+    }
+    pending.resize(shardCount);
+    reportedQueue.assign(shardCount, 0);
+    for (std::unique_ptr<Shard>& shard : shards) {
+        Shard* target = shard.get();
+        shard->thread = std::thread([this, target] { run_shard(*target); });
+    }
+}
+
+/**
+ * @brief Stops and joins every shard thread.
+ */
+ShardedBalancer::~ShardedBalancer() {
+    for (std::unique_ptr<Shard>& shard : shards) {
+        ShardMessage stop;
+        stop.type = ShardMessage::STOP;
+        shard->inbox.send(std::move(stop));
+    }
+    for (std::unique_ptr<Shard>& shard : shards) {
+        shard->thread.join();
+    }
+}
+
+/**
+ * @brief Message loop run by each shard's thread.
+ *
+ * Spilled requests are held until the dispatch round so that the order in which
+ * they and the shard's own arrivals reach its queue never depends on scheduling.
+ *
+ * @param shard The shard to run.
+ */
+void ShardedBalancer::run_shard(Shard& shard) {
+    Shard& neighbour = *shards[(shard.id + 1) % shards.size()];
+    for (;;) {
+        ShardMessage message = shard.inbox.receive();
+        switch (message.type) {
+        case ShardMessage::ARRIVALS: {
+            ShardMessage spill;
+            spill.type = ShardMessage::SPILL;
+            for (Request& request : message.requests) {
+                int queued = shard.balancer.get_queue_size();
+                if (spillThreshold > 0 && &neighbour != &shard && queued >= spillThreshold
+                    && message.neighbourQueue < queued) {
+                    spill.requests.push_back(std::move(request));
+                } else {
+                    shard.balancer.add_request(request);
+                }
+            }
+            if (!spill.requests.empty()) {
+                shard.spilledOut += spill.requests.size();
+                neighbour.inbox.send(std::move(spill));
+            }
+            reports.send({shard.id, shard.balancer.get_queue_size()});
+            break;
+        }
+        case ShardMessage::SPILL:
+            for (Request& request : message.requests) {
+                shard.spilledIn.push_back(std::move(request));
+            }
+            break;
+        case ShardMessage::DISPATCH:
+            for (const Request& request : shard.spilledIn) {
+                shard.balancer.add_request(request);
+            }
+            shard.spilledIn.clear();
+            shard.balancer.distribute_requests();
+            reports.send({shard.id, shard.balancer.get_queue_size()});
+            break;
+        case ShardMessage::STOP:
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Waits for a number of shard reports and records their queue sizes.
+ *
+ * @param expected Number of reports to wait for.
+ */
+void ShardedBalancer::collect_reports(int expected) {
+    for (int i = 0; i < expected; ++i) {
+        ShardReport report = reports.receive();
+        reportedQueue[report.shard] = report.queueSize;
+    }
+}
+
+/**
+ * @brief Picks the shard that owns a request.
+ *
+ * @param request The request to route.
+ * @return int The shard index.
+ */
+int ShardedBalancer::route(const Request& request) const {
+    if (!partitionHeader.empty()) {
+        string value = request.get_header(partitionHeader);
+        if (!value.empty()) return jump_consistent_hash(fnv1a_hash(value), shards.size());
+    }
+    return jump_consistent_hash(fnv1a_hash(request.get_url()), shards.size());
+}
+
+/**
+ * @brief Queues a request for its shard; it is delivered on the next cycle.
+ *
+ * @param request The request to add.
+ */
+void ShardedBalancer::add_request(const Request& request) {
+    pending[route(request)].push_back(request);
+}
+
+/**
+ * @brief Runs one cycle on every shard and waits for them to finish it.
+ *
+ * Only shards with arrivals take part in the route round. Every shard reports
+ * before the dispatch round starts, so each spill message is already in its
+ * neighbour's inbox ahead of the dispatch message.
+ */
+void ShardedBalancer::distribute_requests() {
+    int size = shards.size();
+    int routed = 0;
+    for (int i = 0; i < size; ++i) {
+        if (pending[i].empty()) continue;
+        ShardMessage arrivals;
+        arrivals.type = ShardMessage::ARRIVALS;
+        arrivals.requests.swap(pending[i]);
+        arrivals.neighbourQueue = reportedQueue[(i + 1) % size];
+        shards[i]->inbox.send(std::move(arrivals));
+        routed++;
+    }
+    collect_reports(routed);
+
+    for (std::unique_ptr<Shard>& shard : shards) {
+        ShardMessage dispatch;
+        dispatch.type = ShardMessage::DISPATCH;
+        shard->inbox.send(std::move(dispatch));
+    }
+    collect_reports(size);
+    count++;
+}
+
+/**
+ * @brief Partitions requests on a header instead of the URL.
+ *
+ * @param header The header name; empty to partition on the URL.
+ */
+void ShardedBalancer::set_partition_header(const std::string& header) {
+    partitionHeader = header;
+}
+
+/**
+ * @brief Publishes every shard's metrics, labelled shard="i".
+ *
+ * @param registry The registry to register metrics in.
+ */
+void ShardedBalancer::enable_metrics(MetricsRegistry& registry) {
+    for (std::unique_ptr<Shard>& shard : shards) {
+        shard->balancer.enable_metrics(registry, "shard=\"" + std::to_string(shard->id) + "\"");
+    }
+}
+
+/**
+ * @brief Seeds every shard from one master seed.
+ *
+ * Shard i is seeded from stream 16 + i, clear of the streams used by main().
+ *
+ * @param seed Any 64-bit value.
+ */
+void ShardedBalancer::seed(uint64_t seed) {
+    for (std::unique_ptr<Shard>& shard : shards) {
+        shard->balancer.seed(derive_seed(seed, 16 + shard->id));
+    }
+}
+
+/**
+ * @brief Turns per-cycle console logging on or off for every shard.
+ *
+ * @param enabled True to log.
+ */
+void ShardedBalancer::set_verbose(bool enabled) {
+    for (std::unique_ptr<Shard>& shard : shards) {
+        shard->balancer.set_verbose(enabled);
+    }
+}
+
+/**
+ * @brief Sets the simulated processing delay of every shard.
+ *
+ * @param milliseconds Upper bound of the wall-clock delay; 0 disables it.
+ */
+void ShardedBalancer::set_max_processing_delay(int milliseconds) {
+    for (std::unique_ptr<Shard>& shard : shards) {
+        shard->balancer.set_max_processing_delay(milliseconds);
+    }
+}
+
+/**
+ * @brief Gets the number of shards.
+ *
+ * @return int Shard count.
+ */
+int ShardedBalancer::get_shard_count() const {
+    return shards.size();
+}
+
+/**
+ * @brief Gets one shard's LoadBalancer.
+ *
+ * @param index The shard index.
+ * @return LoadBalancer& The shard's LoadBalancer.
+ */
+LoadBalancer& ShardedBalancer::get_shard(int index) {
+    return shards[index]->balancer;
+}
+
+/**
+ * @brief Gets the number of requests one shard has spilled to its neighbour.
+ *
+ * @param index The shard index.
+ * @return long long Spilled request count.
+ */
+long long ShardedBalancer::get_spilled(int index) const {
+    return shards[index]->spilledOut;
+}
+
+/**
+ * @brief Gets the total number of queued requests across shards.
+ *
+ * @return int Queue size.
+ */
+int ShardedBalancer::get_queue_size() {
+    int total = 0;
+    for (std::unique_ptr<Shard>& shard : shards) {
+        total += shard->balancer.get_queue_size();
+    }
+    return total;
+}
+
+/**
+ * @brief Gets the number of requests completed across shards.
+ *
+ * @return long long Completed request count.
+ */
+long long ShardedBalancer::get_completed_requests() const {
+    long long total = 0;
+    for (const std::unique_ptr<Shard>& shard : shards) {
+        total += shard->balancer.get_completed_requests();
+    }
+    return total;
+}
+
+/**
+ * @brief Gets the server-cycles spent across shards.
+ *
+ * @return long long Server-cycles.
+ */
+long long ShardedBalancer::get_server_cycles() const {
+    long long total = 0;
+    for (const std::unique_ptr<Shard>& shard : shards) {
+        total += shard->balancer.get_server_cycles();
+    }
+    return total;
+}
+
+/**
+ * @brief Gets the price of the servers provisioned across shards.
+ *
+ * @return double Server cost.
+ */
+double ShardedBalancer::get_server_cost() const {
+    double total = 0.0;
+    for (const std::unique_ptr<Shard>& shard : shards) {
+        total += shard->balancer.get_server_cost();
+    }
+    return total;
+}
+
+/**
+ * @brief Merges the latency histograms of every shard.
+ *
+ * @return LatencyHistogram The tier-wide latency histogram.
+ */
+LatencyHistogram ShardedBalancer::get_latency_histogram() const {
+    LatencyHistogram merged;
+    for (const std::unique_ptr<Shard>& shard : shards) {
+        merged.merge(shard->balancer.get_latency_histogram());
+    }
+    return merged;
+}
+
+/**
+ * @brief Gets the number of cycles the tier has run.
+ *
+ * @return int The current simulation cycle.
+ */
+int ShardedBalancer::get_cycle() const {
+    return count;
+}
@@ -0,0 +1,243 @@
+#ifndef SHARDEDBALANCER_H
+#define SHARDEDBALANCER_H
+#include "LoadBalancer.h"
+#include "Mailbox.h"
+#include "LatencyHistogram.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file ShardedBalancer.h
+ * @brief Defines the ShardedBalancer class, a tier of independent LoadBalancer shards.
+ *
+ * Each shard is a complete LoadBalancer with its own queue and servers, running on
+ * its own thread. Requests are partitioned across shards by consistent hashing, and
+ * a shard whose queue is over the spill threshold forwards new arrivals to its
+ * neighbour instead. Shards share no memory: arrivals, spilled requests, cycle
+ * ticks and load reports all travel as messages through Mailboxes.
+ *
+ * @see LoadBalancer
+ * @see Mailbox
+ */
+
+/**
+ * @class ShardedBalancer
+ * @brief Models a multi-node deployment of N balancers behind a hash partitioner.
+ *
+ * Every call to distribute_requests() runs one cycle in two message rounds:
+ *
+ * 1. Route: each shard with new arrivals queues them locally or, when overloaded,
+ *    forwards them to shard (i + 1) mod N in a single spill message.
+ * 2. Dispatch: each shard queues the requests spilled to it and runs one cycle of
+ *    its LoadBalancer, then reports its queue size back.
+ *
+ * A shard only spills while its neighbour's last reported queue is shorter than its
+ * own, so load is never pushed onto a busier node. That report is one cycle old,
+ * as it would be on a real network. Spilled requests take one hop at most. The
+ * round structure makes runs deterministic whatever the thread scheduling.
+ */
+class ShardedBalancer {
+private:
+
+    /**
+     * @brief A message sent to a shard.
+     */
+    struct ShardMessage {
+        enum Type { ARRIVALS, SPILL, DISPATCH, STOP };
+        Type type;
+        std::vector<Request> requests;
+        int neighbourQueue = 0;
+    };
+
+    /**
+     * @brief A shard's reply to the coordinator at the end of a round.
+     */
+    struct ShardReport {
+        int shard;
+        int queueSize;
+    };
+
+    /**
+     * @brief One balancer node and the thread that runs it.
+     */
+    struct Shard {
+        int id;
+        LoadBalancer balancer;
+        Mailbox<ShardMessage> inbox;
+        std::vector<Request> spilledIn;
+        long long spilledOut = 0;
+        std::thread thread;
+
+        Shard(int id, int portBase, int maxServers) : id(id), balancer(0, portBase, maxServers) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<std::vector<Request>> pending;
+    std::vector<int> reportedQueue;
+    Mailbox<ShardReport> reports;
+    int spillThreshold;
+    std::string partitionHeader;
+    int count;
+
+    /**
+     * @brief Message loop run by each shard's thread.
+     */
+    void run_shard(Shard& shard);
+
+    /**
+     * @brief Waits for a number of shard reports and records their queue sizes.
+     */
+    void collect_reports(int expected);
+
+public:
+
+    /**
+     * @brief Constructs the tier and starts one thread per shard.
+     *
+     * Shards start silent with no servers and scale up to maxServers each.
+     *
+     * @param shardCount Number of balancer shards.
+     * @param maxServers Maximum servers per shard.
+     * @param spillThreshold Queue length at which a shard spills to its neighbour; 0 disables spillover.
+     */
+    ShardedBalancer(int shardCount, int maxServers, int spillThreshold);
+
+    /**
+     * @brief Stops and joins every shard thread.
+     */
+    ~ShardedBalancer();
+
+    ShardedBalancer(const ShardedBalancer&) = delete;
+    ShardedBalancer& operator=(const ShardedBalancer&) = delete;
+
+    /**
+     * @brief Picks the shard that owns a request.
+     *
+     * @param request The request to route.
+     * @return The shard index, from the partition header if set and present, else the URL.
+     */
+    int route(const Request& request) const;
+
+    /**
+     * @brief Queues a request for its shard; it is delivered on the next cycle.
+     *
+     * @param request The request to add.
+     */
+    void add_request(const Request& request);
+
+    /**
+     * @brief Runs one cycle on every shard and waits for them to finish it.
+     */
+    void distribute_requests();
+
+    /**
+     * @brief Partitions requests on a header instead of the URL.
+     *
+     * Keeps each session on one shard, which sticky sessions within a shard need.
+     *
+     * @param header The header name; empty to partition on the URL.
+     */
+    void set_partition_header(const std::string& header);
+
+    /**
+     * @brief Publishes every shard's metrics, labelled shard="i".
+     *
+     * @param registry The registry to register metrics in; must outlive the tier.
+     */
+    void enable_metrics(MetricsRegistry& registry);
+
+    /**
+     * @brief Seeds every shard from one master seed.
+     *
+     * @param seed Any 64-bit value.
+     */
+    void seed(uint64_t seed);
+
+    /**
+     * @brief Turns per-cycle console logging on or off for every shard.
+     *
+     * Shards log from their own threads, so lines from different shards interleave.
+     *
+     * @param enabled True to log.
+     */
+    void set_verbose(bool enabled);
+
+    /**
+     * @brief Sets the simulated processing delay of every shard.
+     *
+     * @param milliseconds Upper bound of the wall-clock delay; 0 disables it.
+     */
+    void set_max_processing_delay(int milliseconds);
+
+    /**
+     * @brief Gets the number of shards.
+     *
+     * @return Shard count.
+     */
+    int get_shard_count() const;
+
+    /**
+     * @brief Gets one shard's LoadBalancer for configuration or inspection.
+     *
+     * Only safe between calls to distribute_requests(), when every shard is idle.
+     *
+     * @param index The shard index.
+     * @return The shard's LoadBalancer.
+     */
+    LoadBalancer& get_shard(int index);
+
+    /**
+     * @brief Gets the number of requests one shard has spilled to its neighbour.
+     *
+     * @param index The shard index.
+     * @return Spilled request count.
+     */
+    long long get_spilled(int index) const;
+
+    /**
+     * @brief Gets the total number of queued requests across shards.
+     *
+     * @return Queue size, excluding requests not yet delivered.
+     */
+    int get_queue_size();
+
+    /**
+     * @brief Gets the number of requests completed across shards.
+     *
+     * @return Completed request count.
+     */
+    long long get_completed_requests() const;
+
+    /**
+     * @brief Gets the server-cycles spent across shards.
+     *
+     * @return Server-cycles.
+     */
+    long long get_server_cycles() const;
+
+    /**
+     * @brief Gets the price of the servers provisioned across shards.
+     *
+     * @return Server cost.
+     */
+    double get_server_cost() const;
+
+    /**
+     * @brief Merges the latency histograms of every shard.
+     *
+     * @return The tier-wide latency histogram.
+     */
+    LatencyHistogram get_latency_histogram() const;
+
+    /**
+     * @brief Gets the number of cycles the tier has run.
+     *
+     * @return The current simulation cycle.
+     */
+    int get_cycle() const;
+};
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file Snapshot.cpp
+ * @brief Implementation of simulation checkpointing and restore.
+ *
+ * @see LoadBalancer::save
+ * @see Workload::save
+ *
+ */
+
+#include "Snapshot.h"
+#include "utils.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+/** Identifies a snapshot file. */
+static const char SNAPSHOT_MAGIC[8] = {'L', 'B', 'S', 'N', 'A', 'P', '\0', '\0'};
+
+/** Bumped whenever the layout of any saved class changes. */
+static const uint32_t SNAPSHOT_VERSION = 9;
+
+/**
+ * @brief Writes a snapshot file.
+ *
+ * @param path Destination file.
+ * @param lb The LoadBalancer to save.
+ * @param workload The Workload driving it.
+ * @return true On success.
+ */
+bool save_snapshot(const std::string& path, const LoadBalancer& lb, const Workload& workload) {
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        write_value(out, SNAPSHOT_VERSION);
+        lb.save(out);
+        workload.save(out);
+        out.flush();
+        if (!out) return false;
+    }
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+
+/**
+ * @brief Restores a snapshot file written by save_snapshot().
+ *
+ * @param path Snapshot file.
+ * @param lb Replaced with the saved LoadBalancer state.
+ * @param workload Replaced with the saved Workload state.
+ * @return true On success.
+ */
+bool load_snapshot(const std::string& path, LoadBalancer& lb, Workload& workload) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    uint32_t version = 0;
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) return false;
+    if (!read_value(in, version) || version != SNAPSHOT_VERSION) return false;
+
+    return lb.restore(in) && workload.restore(in);
+}
@@ -0,0 +1,46 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include "LoadBalancer.h"
+#include "Workload.h"
+#include <string>
+
+/**
+ * @file Snapshot.h
+ * @brief Functions to checkpoint a simulation to a binary file and restore it.
+ *
+ * A snapshot holds the full LoadBalancer state together with the Workload's random
+ * and arrival process state, so a restored run produces exactly the same results
+ * as the original run would have from that cycle on. That allows long simulations
+ * to be resumed, or forked into what-if experiments from a shared starting point.
+ *
+ * The file starts with a magic string and a format version; all values are stored
+ * in host byte order.
+ */
+
+/**
+ * @brief Writes a snapshot file.
+ *
+ * The snapshot is written to a temporary file and renamed into place, so an
+ * interrupted checkpoint never leaves a truncated file behind.
+ *
+ * @param path Destination file.
+ * @param lb The LoadBalancer to save.
+ * @param workload The Workload driving it.
+ * @return True on success.
+ */
+bool save_snapshot(const std::string& path, const LoadBalancer& lb, const Workload& workload);
+
+/**
+ * @brief Restores a snapshot file written by save_snapshot().
+ *
+ * The Workload must have been built from the same arrival and service specs as the
+ * one that was saved.
+ *
+ * @param path Snapshot file.
+ * @param lb Replaced with the saved LoadBalancer state.
+ * @param workload Replaced with the saved Workload state.
+ * @return True on success, false if the file is missing, truncated or of another version.
+ */
+bool load_snapshot(const std::string& path, LoadBalancer& lb, Workload& workload);
+
+#endif
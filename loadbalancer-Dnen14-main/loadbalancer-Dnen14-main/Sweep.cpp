@@ -0,0 +1,332 @@
+/**
+ * @file Sweep.cpp
+ * @brief Implementation of the parallel Monte Carlo sweep engine.
+ *
+ * @see SweepRunner
+ *
+ */
+
+#include "Sweep.h"
+#include "HierarchicalBalancer.h"
+#include "ShardedBalancer.h"
+#include "Workload.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+/** Number of distinct session cookies generated for sticky-session policies. */
+static const int SESSION_COUNT = 256;
+
+/** Shards, memory budget in bytes and TTL in cycles of the "cache" policy's response cache. */
+static const int CACHE_SHARDS = 16;
+static const size_t CACHE_MEMORY = 64 << 20;
+static const int CACHE_TTL = 100;
+
+/** Two-sided 95% Student t critical values for 1..30 degrees of freedom. */
+static const double T_CRITICAL[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+bool apply_policy(LoadBalancer& lb, const std::string& policy) {
+    if (policy == "round-robin") {
+        return true;
+    } else if (policy == "sticky") {
+        lb.set_sticky_header("Cookie");
+        return true;
+    } else if (policy == "health") {
+        lb.enable_health_checks(true);
+        return true;
+    } else if (policy == "edf") {
+        lb.set_queue_order(QueueOrder::EDF);
+        return true;
+    } else if (policy == "fastest") {
+        lb.set_dispatch_policy(DispatchPolicy::FASTEST_COMPLETION);
+        return true;
+    } else if (policy == "cache") {
+        lb.enable_cache(CACHE_SHARDS, CACHE_MEMORY, CACHE_TTL);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Feeds a workload through a LoadBalancer or ShardedBalancer and measures it.
+ *
+ * Each request belongs to one of SESSION_COUNT sessions, which sets both its URL
+ * and its Cookie header, so hash partitioning and sticky sessions see a spread of keys.
+ *
+ * @param lb The balancer to drive.
+ * @param workload The traffic generator.
+ * @param config The simulation parameters.
+ * @param sessions Random source for session choice.
+ * @return SimulationResult The measured result.
+ */
+template <typename Balancer>
+static SimulationResult drive(Balancer& lb, Workload& workload, const SimulationConfig& config, Rng& sessions) {
+    std::vector<std::string> urls;
+    std::vector<std::string> headers;
+    for (int i = 0; i < SESSION_COUNT; ++i) {
+        urls.push_back("/task" + std::to_string(i));
+        headers.push_back("Host: loadbalancer.com\nCookie: session=" + std::to_string(i));
+    }
+
+    Request request;
+    request.set_method("GET");
+    for (int cycle = 0; cycle < config.cycles; ++cycle) {
+        int arrivals = workload.next_arrivals(cycle);
+        for (int n = 0; n < arrivals; ++n) {
+            int session = sessions.uniform_int(0, SESSION_COUNT - 1);
+            request.set_url(urls[session]);
+            request.set_headers(headers[session]);
+            request.set_task_time(workload.next_task_time());
+            int timeout = workload.next_timeout();
+            request.set_deadline(timeout > 0 ? cycle + timeout : -1);
+            lb.add_request(request);
+        }
+        lb.distribute_requests();
+    }
+
+    SimulationResult result;
+    result.valid = true;
+    result.completed = lb.get_completed_requests();
+    result.throughput = config.cycles > 0 ? (double) result.completed / config.cycles : 0.0;
+    result.p99Latency = lb.get_latency_histogram().percentile(99.0);
+    result.serverCycles = lb.get_server_cycles();
+    result.serverCost = lb.get_server_cost();
+    return result;
+}
+
+bool parse_fleet(const std::string& fleet, std::vector<InstanceType>& types) {
+    types.clear();
+    size_t start = 0;
+    while (start < fleet.size()) {
+        size_t end = fleet.find('+', start);
+        if (end == std::string::npos) end = fleet.size();
+        InstanceType type;
+        if (!parse_instance_type(fleet.substr(start, end - start), type)) return false;
+        types.push_back(type);
+        start = end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Applies the per-balancer parts of a configuration.
+ *
+ * @param lb The balancer, or one shard or rack of a larger topology.
+ * @param config The simulation parameters.
+ * @return bool False if the fleet, the timeout or the policy is invalid.
+ */
+static bool configure(LoadBalancer& lb, const SimulationConfig& config) {
+    std::vector<InstanceType> types;
+    int timeout = 0;
+    std::unique_ptr<ServiceTime> distribution;
+    if (!parse_fleet(config.fleet, types) || !parse_timeout(config.timeout, timeout, distribution)) return false;
+    lb.set_instance_types(types);
+    lb.set_scaling_thresholds(config.scaleUp, config.scaleDown);
+    lb.set_request_timeout(timeout);
+    lb.set_drain_timeout(config.drainTimeout);
+    lb.set_dispatch_batch(config.batch);
+    return apply_policy(lb, config.policy);
+}
+
+/**
+ * @brief Adds one balancer's deadline, drain and cache figures to a result.
+ *
+ * @param lb The balancer, or one shard or rack of a larger topology.
+ * @param result Gets the requests dropped or cancelled after their deadline and the cache hits.
+ * @param drainLatencies Gets the latencies of requests caught by a scale-down.
+ */
+static void collect(LoadBalancer& lb, SimulationResult& result, LatencyHistogram& drainLatencies) {
+    result.expired += lb.get_expired_requests() + lb.get_cancelled_requests();
+    if (lb.get_cache()) result.cacheHits += lb.get_cache()->get_hits();
+    drainLatencies.merge(lb.get_drain_latency_histogram());
+}
+
+SimulationResult run_simulation(const SimulationConfig& config) {
+    std::unique_ptr<ArrivalProcess> arrivalProcess = make_arrival_process(config.arrivals);
+    std::unique_ptr<ServiceTime> serviceTime = make_service_time(config.service);
+    int timeout = 0;
+    std::unique_ptr<ServiceTime> timeouts;
+    if (!arrivalProcess || !serviceTime || !parse_timeout(config.timeout, timeout, timeouts)) return SimulationResult();
+    Workload workload(std::move(arrivalProcess), std::move(serviceTime), derive_seed(config.seed, 0));
+    workload.set_timeouts(std::move(timeouts));
+    Rng sessions(derive_seed(config.seed, 3));
+    LatencyHistogram drainLatencies;
+
+    if (config.shards > 1 && config.racks > 1) return SimulationResult();
+    if (config.racks > 1) {
+        HierarchicalBalancer hierarchy(config.racks, config.servers, config.staleness);
+        hierarchy.set_max_processing_delay(0);
+        hierarchy.seed(config.seed);
+        for (int i = 0; i < hierarchy.get_rack_count(); ++i) {
+            if (!configure(hierarchy.get_rack(i), config)) return SimulationResult();
+        }
+        SimulationResult result = drive(hierarchy, workload, config, sessions);
+        result.signalUpdates = hierarchy.get_signal_updates();
+        for (int i = 0; i < hierarchy.get_rack_count(); ++i) collect(hierarchy.get_rack(i), result, drainLatencies);
+        result.drainP99Latency = drainLatencies.percentile(99.0);
+        return result;
+    }
+    if (config.shards > 1) {
+        ShardedBalancer tier(config.shards, config.servers, config.spillThreshold);
+        tier.set_max_processing_delay(0);
+        tier.seed(config.seed);
+        for (int i = 0; i < tier.get_shard_count(); ++i) {
+            if (!configure(tier.get_shard(i), config)) return SimulationResult();
+        }
+        if (config.policy == "sticky") tier.set_partition_header("Cookie");
+        SimulationResult result = drive(tier, workload, config, sessions);
+        for (int i = 0; i < tier.get_shard_count(); ++i) collect(tier.get_shard(i), result, drainLatencies);
+        result.drainP99Latency = drainLatencies.percentile(99.0);
+        return result;
+    }
+
+    LoadBalancer lb(0, 8080, config.servers);
+    lb.set_verbose(false);
+    lb.set_max_processing_delay(0);
+    lb.seed(config.seed);
+    if (!configure(lb, config)) return SimulationResult();
+    SimulationResult result = drive(lb, workload, config, sessions);
+    collect(lb, result, drainLatencies);
+    result.drainP99Latency = drainLatencies.percentile(99.0);
+    return result;
+}
+
+Estimate estimate(const std::vector<double>& values) {
+    Estimate result;
+    size_t n = values.size();
+    if (n == 0) return result;
+    double sum = 0.0;
+    for (double value : values) sum += value;
+    result.mean = sum / n;
+    if (n < 2) return result;
+
+    double squares = 0.0;
+    for (double value : values) squares += (value - result.mean) * (value - result.mean);
+    double stddev = std::sqrt(squares / (n - 1));
+    double t = n - 1 <= 30 ? T_CRITICAL[n - 2] : 1.96;
+    result.halfWidth = t * stddev / std::sqrt((double) n);
+    return result;
+}
+
+/**
+ * @brief Replaces every point with one copy per value of a grid dimension.
+ *
+ * @param points The points built so far.
+ * @param values The dimension's values.
+ * @param set Applies one value to a copy of a point.
+ */
+template <typename T, typename Setter>
+static void expand(std::vector<SimulationConfig>& points, const std::vector<T>& values, Setter set) {
+    std::vector<SimulationConfig> expanded;
+    for (const SimulationConfig& point : points) {
+        for (const T& value : values) {
+            SimulationConfig config = point;
+            set(config, value);
+            expanded.push_back(config);
+        }
+    }
+    points.swap(expanded);
+}
+
+/**
+ * @brief Constructs a SweepRunner.
+ *
+ * @param threads Number of worker threads; 0 uses every hardware thread.
+ */
+SweepRunner::SweepRunner(int threads) : threads(threads) {
+    if (this->threads <= 0) this->threads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Runs every grid point for every seed and aggregates the results.
+ *
+ * Combinations of more than one shard with more than one rack cannot be
+ * simulated; they are left out with a message on stderr. Jobs are laid out
+ * point-major, so all seeds of a grid point are adjacent and the seed of run s
+ * is derived from baseSeed and s alone.
+ *
+ * @param grid The sweep parameters.
+ * @return std::vector<SweepPoint> One aggregated point per grid combination.
+ */
+std::vector<SweepPoint> SweepRunner::run(const SweepGrid& grid) {
+    std::vector<SimulationConfig> points(1);
+    points[0].spillThreshold = grid.spillThreshold;
+    points[0].cycles = grid.cycles;
+    expand(points, grid.shards, [](SimulationConfig& config, int value) { config.shards = value; });
+    expand(points, grid.racks, [](SimulationConfig& config, int value) { config.racks = value; });
+    points.erase(std::remove_if(points.begin(), points.end(), [](const SimulationConfig& config) {
+        if (config.shards <= 1 || config.racks <= 1) return false;
+        std::cerr << "Skipping shards=" << config.shards << " racks=" << config.racks
+                  << ": a tier cannot be both sharded and racked." << std::endl;
+        return true;
+    }), points.end());
+    expand(points, grid.staleness, [](SimulationConfig& config, int value) { config.staleness = value; });
+    expand(points, grid.servers, [](SimulationConfig& config, int value) { config.servers = value; });
+    expand(points, grid.fleets, [](SimulationConfig& config, const std::string& value) { config.fleet = value; });
+    expand(points, grid.policies, [](SimulationConfig& config, const std::string& value) { config.policy = value; });
+    expand(points, grid.arrivals, [](SimulationConfig& config, const std::string& value) { config.arrivals = value; });
+    expand(points, grid.services, [](SimulationConfig& config, const std::string& value) { config.service = value; });
+    expand(points, grid.timeouts, [](SimulationConfig& config, const std::string& value) { config.timeout = value; });
+    expand(points, grid.drainTimeouts, [](SimulationConfig& config, int value) { config.drainTimeout = value; });
+    expand(points, grid.batches, [](SimulationConfig& config, int value) { config.batch = value; });
+    expand(points, grid.thresholds, [](SimulationConfig& config, const std::pair<int, int>& value) {
+        config.scaleUp = value.first;
+        config.scaleDown = value.second;
+    });
+
+    size_t seeds = std::max(1, grid.seeds);
+    size_t jobs = points.size() * seeds;
+    std::vector<SimulationResult> results(jobs);
+    std::atomic<size_t> nextJob(0);
+
+    auto worker = [&]() {
+        for (size_t job = nextJob++; job < jobs; job = nextJob++) {
+            SimulationConfig config = points[job / seeds];
+            config.seed = derive_seed(grid.baseSeed, job % seeds);
+            results[job] = run_simulation(config);
+        }
+    };
+    std::vector<std::thread> pool;
+    int workers = (int) std::min<size_t>(threads, std::max<size_t>(jobs, 1));
+    for (int i = 0; i < workers; ++i) {
+        pool.emplace_back(worker);
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    std::vector<SweepPoint> sweep;
+    for (size_t p = 0; p < points.size(); ++p) {
+        std::vector<double> throughput, p99, drainP99, cycles, cost, updates, expired, cacheHits;
+        for (size_t s = 0; s < seeds; ++s) {
+            const SimulationResult& result = results[p * seeds + s];
+            if (!result.valid) continue;
+            throughput.push_back(result.throughput);
+            p99.push_back(result.p99Latency);
+            drainP99.push_back(result.drainP99Latency);
+            cycles.push_back(result.serverCycles);
+            cost.push_back(result.serverCost);
+            updates.push_back(result.signalUpdates);
+            expired.push_back(result.expired);
+            cacheHits.push_back(result.cacheHits);
+        }
+        SweepPoint point;
+        point.config = points[p];
+        point.runs = throughput.size();
+        point.throughput = estimate(throughput);
+        point.p99Latency = estimate(p99);
+        point.drainP99Latency = estimate(drainP99);
+        point.serverCycles = estimate(cycles);
+        point.serverCost = estimate(cost);
+        point.signalUpdates = estimate(updates);
+        point.expired = estimate(expired);
+        point.cacheHits = estimate(cacheHits);
+        sweep.push_back(point);
+    }
+    return sweep;
+}
@@ -0,0 +1,195 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+#include "LoadBalancer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @file Sweep.h
+ * @brief Defines the SweepRunner class, a parallel Monte Carlo engine for capacity planning.
+ *
+ * A sweep runs many independent, seeded LoadBalancer simulations over a grid of
+ * shard and rack counts, signal staleness bounds, server counts, instance type
+ * fleets, dispatch policies, scaling thresholds and workloads, spreading them
+ * across a pool of threads. Runs that differ only in their seed are then
+ * aggregated into means with 95% confidence intervals for throughput, p99 latency
+ * overall and while scaling down, server-cycles and server cost.
+ *
+ * Every configuration with the same seed index sees the same arrivals and task
+ * times (common random numbers), so differences between grid points reflect the
+ * configuration rather than sampling noise.
+ */
+
+/**
+ * @struct SimulationConfig
+ * @brief Everything needed to run one simulation.
+ */
+struct SimulationConfig {
+    int servers = 1;
+    std::string fleet;
+    int shards = 1;
+    int spillThreshold = 0;
+    int racks = 1;
+    int staleness = 0;
+    std::string policy = "round-robin";
+    std::string arrivals = "poisson:0.2";
+    std::string service = "uniform:1,5";
+    int scaleUp = 5;
+    int scaleDown = 2;
+    std::string timeout = "0";
+    int drainTimeout = -1;
+    int batch = 1;
+    int cycles = 10000;
+    uint64_t seed = 1;
+};
+
+/**
+ * @struct SimulationResult
+ * @brief Outcome of one simulation.
+ */
+struct SimulationResult {
+    bool valid = false;
+    long long completed = 0;
+    double throughput = 0.0;
+    double p99Latency = 0.0;
+    double drainP99Latency = 0.0;
+    double serverCycles = 0.0;
+    double serverCost = 0.0;
+    double signalUpdates = 0.0;
+    double expired = 0.0;
+    double cacheHits = 0.0;
+};
+
+/**
+ * @struct Estimate
+ * @brief A sample mean with the half-width of its 95% confidence interval.
+ */
+struct Estimate {
+    double mean = 0.0;
+    double halfWidth = 0.0;
+};
+
+/**
+ * @struct SweepPoint
+ * @brief Aggregated results for one grid point across all seeds.
+ */
+struct SweepPoint {
+    SimulationConfig config;
+    int runs = 0;
+    Estimate throughput;
+    Estimate p99Latency;
+    Estimate drainP99Latency;
+    Estimate serverCycles;
+    Estimate serverCost;
+    Estimate signalUpdates;
+    Estimate expired;
+    Estimate cacheHits;
+};
+
+/**
+ * @struct SweepGrid
+ * @brief The parameter grid of a sweep; every combination is run once per seed.
+ */
+struct SweepGrid {
+    std::vector<int> servers = {1, 2, 4, 8};
+    std::vector<std::string> fleets = {""};
+    std::vector<int> shards = {1};
+    int spillThreshold = 0;
+    std::vector<int> racks = {1};
+    std::vector<int> staleness = {0};
+    std::vector<std::string> policies = {"round-robin"};
+    std::vector<std::string> arrivals = {"poisson:0.2"};
+    std::vector<std::string> services = {"uniform:1,5"};
+    std::vector<std::pair<int, int>> thresholds = {{5, 2}};
+    std::vector<std::string> timeouts = {"0"};
+    std::vector<int> drainTimeouts = {-1};
+    std::vector<int> batches = {1};
+    int seeds = 10;
+    uint64_t baseSeed = 1;
+    int cycles = 10000;
+};
+
+/**
+ * @brief Configures a LoadBalancer for a named dispatch policy.
+ *
+ * Known policies: "round-robin", "sticky" (sessions keyed on the Cookie header),
+ * "health" (round-robin with health checking), "edf" (round-robin with the
+ * queue served earliest deadline first), "fastest" (each request sent to the
+ * server expected to finish it first) and "cache" (round-robin behind a
+ * response cache that answers repeated GETs for 100 cycles).
+ *
+ * @param lb The LoadBalancer to configure.
+ * @param policy The policy name.
+ * @return True if the policy is known.
+ */
+bool apply_policy(LoadBalancer& lb, const std::string& policy);
+
+/**
+ * @brief Parses a fleet such as "old:0.5,1+new:2,2" into instance types.
+ *
+ * @param fleet '+'-separated instance type specs (see parse_instance_type()); empty for standard servers.
+ * @param types Set to the parsed types.
+ * @return True if every spec parsed.
+ */
+bool parse_fleet(const std::string& fleet, std::vector<InstanceType>& types);
+
+/**
+ * @brief Runs one silent, seeded simulation.
+ *
+ * With more than one shard the simulation runs a ShardedBalancer tier, and with
+ * more than one rack a HierarchicalBalancer whose signals may be up to staleness
+ * cycles old; in both, servers is the per-shard or per-rack maximum. Asking for
+ * both shards and racks gives an invalid result. The fleet is a '+'-separated
+ * list of instance type specs (see parse_instance_type()) that servers are
+ * provisioned from in turn; empty for standard servers.
+ *
+ * @param config The simulation parameters.
+ * @return The result; valid is false if a spec, the fleet or the policy is unknown.
+ */
+SimulationResult run_simulation(const SimulationConfig& config);
+
+/**
+ * @brief Computes the mean and 95% confidence half-width of a sample.
+ *
+ * Uses Student's t distribution, so the interval is honest for a handful of seeds.
+ *
+ * @param values The sample.
+ * @return The estimate; the half-width is 0 for fewer than two values.
+ */
+Estimate estimate(const std::vector<double>& values);
+
+/**
+ * @class SweepRunner
+ * @brief Runs a SweepGrid across a pool of worker threads.
+ *
+ * Simulations share nothing, so workers simply claim the next job index from an
+ * atomic counter and write into their own result slot; no locks are taken. Results
+ * are identical whatever the thread count.
+ */
+class SweepRunner {
+private:
+    int threads;
+
+public:
+
+    /**
+     * @brief Constructs a SweepRunner.
+     *
+     * @param threads Number of worker threads; 0 uses every hardware thread.
+     */
+    explicit SweepRunner(int threads);
+
+    /**
+     * @brief Runs every grid point for every seed and aggregates the results.
+     *
+     * Combinations of more than one shard with more than one rack are skipped
+     * with a message on stderr.
+     *
+     * @param grid The sweep parameters.
+     * @return One aggregated point per grid combination, in grid order.
+     */
+    std::vector<SweepPoint> run(const SweepGrid& grid);
+};
+
+#endif
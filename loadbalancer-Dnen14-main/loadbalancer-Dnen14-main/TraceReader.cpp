@@ -0,0 +1,213 @@
+/**
+ * @file TraceReader.cpp
+ * @brief Implementation of the TraceReader class for streaming access logs via mmap.
+ *
+ * The mapping is advised as sequential so the kernel reads ahead aggressively, and
+ * every RELEASE_CHUNK bytes the pages behind the cursor are dropped with
+ * MADV_DONTNEED. Because the mapping is private and read-only, dropped pages are
+ * simply re-read from the file if they are ever touched again.
+ *
+ * @see TraceReader
+ *
+ */
+
+#include "TraceReader.h"
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** Number of consumed bytes to accumulate before releasing them. */
+static const size_t RELEASE_CHUNK = 64 * 1024 * 1024;
+
+/**
+ * @brief Constructs a reader with no file open.
+ */
+TraceReader::TraceReader()
+    : fd(-1), data(nullptr), length(0), position(0), releasedUpTo(0), skippedLines(0) {}
+
+/**
+ * @brief Unmaps and closes the trace file.
+ */
+TraceReader::~TraceReader() {
+    close();
+}
+
+/**
+ * @brief Opens and maps a trace file.
+ *
+ * An empty file opens successfully and simply yields no records.
+ *
+ * @param path Path of the access log.
+ * @return true On success.
+ * @return false If the file cannot be opened or mapped.
+ */
+bool TraceReader::open(const string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close();
+        return false;
+    }
+    length = info.st_size;
+    if (length == 0) return true;
+
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+    data = static_cast<const char*>(mapping);
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    return true;
+}
+
+/**
+ * @brief Unmaps and closes the trace file, if one is open.
+ */
+void TraceReader::close() {
+    if (data) munmap(const_cast<char*>(data), length);
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    data = nullptr;
+    length = 0;
+    position = 0;
+    releasedUpTo = 0;
+    skippedLines = 0;
+}
+
+/**
+ * @brief Drops already-parsed pages from the mapping.
+ *
+ * Only whole pages strictly behind the cursor are released.
+ */
+void TraceReader::release_consumed() {
+    if (position - releasedUpTo < RELEASE_CHUNK) return;
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t end = position / pageSize * pageSize;
+    if (end <= releasedUpTo) return;
+    madvise(const_cast<char*>(data) + releasedUpTo, end - releasedUpTo, MADV_DONTNEED);
+    releasedUpTo = end;
+}
+
+/**
+ * @brief Returns the next whitespace-separated field of a line and advances past it.
+ *
+ * @param cursor Current position; moved to the end of the field.
+ * @param end End of the line.
+ * @param fieldEnd Set to the end of the field.
+ * @return const char* Start of the field, or nullptr if the line has no more fields.
+ */
+static const char* next_field(const char*& cursor, const char* end, const char*& fieldEnd) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) cursor++;
+    if (cursor == end) return nullptr;
+    const char* start = cursor;
+    while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r') cursor++;
+    fieldEnd = cursor;
+    return start;
+}
+
+/**
+ * @brief Parses a number occupying exactly [begin, end).
+ *
+ * The field is copied to a small stack buffer first because the mapping is not
+ * NUL-terminated.
+ *
+ * @param begin Start of the field.
+ * @param end End of the field.
+ * @param value Set to the parsed number.
+ * @return true If the whole field is a valid, finite number.
+ */
+static bool parse_number(const char* begin, const char* end, double& value) {
+    char buffer[64];
+    size_t size = end - begin;
+    if (size == 0 || size >= sizeof(buffer)) return false;
+    for (size_t i = 0; i < size; ++i) buffer[i] = begin[i];
+    buffer[size] = '\0';
+    char* parsedEnd = nullptr;
+    errno = 0;
+    value = std::strtod(buffer, &parsedEnd);
+    return *parsedEnd == '\0' && errno == 0 && std::isfinite(value);
+}
+
+/**
+ * @brief Parses a single line into a record.
+ *
+ * @param begin Start of the line.
+ * @param end End of the line, excluding the newline.
+ * @param record Filled in on success.
+ * @return true If the line holds all five fields, with a size and service time
+ * that are not negative and a size that fits in a long long.
+ */
+bool TraceReader::parse_line(const char* begin, const char* end, TraceRecord& record) {
+    const char* cursor = begin;
+    const char* fieldEnd = nullptr;
+    double size = 0.0;
+
+    const char* field = next_field(cursor, end, fieldEnd);
+    if (!field || !parse_number(field, fieldEnd, record.timestamp)) return false;
+    field = next_field(cursor, end, fieldEnd);
+    if (!field) return false;
+    record.method.assign(field, fieldEnd);
+    field = next_field(cursor, end, fieldEnd);
+    if (!field) return false;
+    record.url.assign(field, fieldEnd);
+    field = next_field(cursor, end, fieldEnd);
+    if (!field || !parse_number(field, fieldEnd, size) || size < 0.0 || size >= (double) LLONG_MAX) return false;
+    record.size = (long long) size;
+    field = next_field(cursor, end, fieldEnd);
+    if (!field || !parse_number(field, fieldEnd, record.serviceTime) || record.serviceTime < 0.0) return false;
+    return next_field(cursor, end, fieldEnd) == nullptr;
+}
+
+/**
+ * @brief Parses the next record.
+ *
+ * @param record Filled in with the next valid record.
+ * @return true If a record was read.
+ * @return false At the end of the trace.
+ */
+bool TraceReader::next(TraceRecord& record) {
+    while (position < length) {
+        const char* begin = data + position;
+        const char* newline = static_cast<const char*>(memchr(begin, '\n', length - position));
+        const char* end = newline ? newline : data + length;
+        position = newline ? position + (newline - begin) + 1 : length;
+
+        const char* first = begin;
+        while (first < end && (*first == ' ' || *first == '\t' || *first == '\r')) first++;
+        if (first == end || *first == '#') continue;
+
+        bool parsed = parse_line(begin, end, record);
+        release_consumed();
+        if (parsed) return true;
+        skippedLines++;
+    }
+    return false;
+}
+
+/**
+ * @brief Gets the number of malformed lines skipped so far.
+ *
+ * @return long long Skipped line count.
+ */
+long long TraceReader::get_skipped_lines() const {
+    return skippedLines;
+}
+
+/**
+ * @brief Gets how far into the file the reader has advanced.
+ *
+ * @return size_t Bytes consumed.
+ */
+size_t TraceReader::get_bytes_read() const {
+    return position;
+}
@@ -0,0 +1,108 @@
+#ifndef TRACEREADER_H
+#define TRACEREADER_H
+#include <cstddef>
+#include <string>
+using std::string;
+
+/**
+ * @file TraceReader.h
+ * @brief Defines the TraceReader class, a streaming parser for recorded access logs.
+ *
+ * A trace is a text file with one request per line:
+ *
+ *     timestamp method url size service_time
+ *
+ * where timestamp and service_time are in seconds and size is the response size in
+ * bytes. Fields are separated by spaces or tabs; blank lines and lines starting with
+ * '#' are ignored, and malformed lines are skipped and counted.
+ */
+
+/**
+ * @struct TraceRecord
+ * @brief One parsed access log line.
+ */
+struct TraceRecord {
+    double timestamp = 0.0;
+    string method;
+    string url;
+    long long size = 0;
+    double serviceTime = 0.0;
+};
+
+/**
+ * @class TraceReader
+ * @brief Reads an access log through a read-only memory mapping, one record at a time.
+ *
+ * The file is never copied into memory: records are parsed straight out of the
+ * mapping, and pages that have been consumed are released back to the kernel as the
+ * reader advances, so resident memory stays flat regardless of the trace size.
+ */
+class TraceReader {
+private:
+    int fd;
+    const char* data;
+    size_t length;
+    size_t position;
+    size_t releasedUpTo;
+    long long skippedLines;
+
+    /**
+     * @brief Drops already-parsed pages from the mapping once enough have accumulated.
+     */
+    void release_consumed();
+
+    /**
+     * @brief Parses a single line into a record.
+     */
+    static bool parse_line(const char* begin, const char* end, TraceRecord& record);
+
+public:
+
+    /**
+     * @brief Constructs a reader with no file open.
+     */
+    TraceReader();
+
+    /**
+     * @brief Unmaps and closes the trace file.
+     */
+    ~TraceReader();
+
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    /**
+     * @brief Opens and maps a trace file.
+     *
+     * @param path Path of the access log.
+     * @return True on success, false if the file cannot be opened or mapped.
+     */
+    bool open(const string& path);
+
+    /**
+     * @brief Unmaps and closes the trace file, if one is open.
+     */
+    void close();
+
+    /**
+     * @brief Parses the next record.
+     *
+     * @param record Filled in with the next valid record; its strings are reused.
+     * @return True if a record was read, false at the end of the trace.
+     */
+    bool next(TraceRecord& record);
+
+    /**
+     * @brief Gets the number of malformed lines skipped so far.
+     * @return Skipped line count.
+     */
+    long long get_skipped_lines() const;
+
+    /**
+     * @brief Gets how far into the file the reader has advanced.
+     * @return Bytes consumed.
+     */
+    size_t get_bytes_read() const;
+};
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file TraceReplayer.cpp
+ * @brief Implementation of the TraceReplayer class for replaying access logs in virtual time.
+ *
+ * @see TraceReplayer
+ * @see TraceReader
+ *
+ */
+
+#include "TraceReplayer.h"
+#include <algorithm>
+#include <cmath>
+
+/** Longest task time a record is given, in cycles, as for generated workloads. */
+static const double MAX_TASK_TIME = 1e9;
+
+/**
+ * @brief Constructs a TraceReplayer.
+ *
+ * @param lb The LoadBalancer to feed.
+ * @param reader An open trace.
+ * @param cyclesPerSecond Simulation cycles per second of recorded time.
+ * @param speedup Factor by which gaps between arrivals are compressed.
+ */
+TraceReplayer::TraceReplayer(LoadBalancer& lb, TraceReader& reader, double cyclesPerSecond, double speedup)
+    : lb(lb), reader(reader), cyclesPerSecond(cyclesPerSecond), speedup(speedup > 0.0 ? speedup : 1.0),
+      replayed(0) {}
+
+/**
+ * @brief Converts a trace record into a Request.
+ *
+ * The recorded service time becomes the task time (at least one cycle, at most
+ * MAX_TASK_TIME) and the recorded size becomes the response size.
+ *
+ * @param record The trace record.
+ * @return Request The request to enqueue.
+ */
+Request TraceReplayer::make_request(const TraceRecord& record) const {
+    Request request;
+    request.set_method(record.method);
+    request.set_url(record.url);
+    request.set_headers("Host: loadbalancer.com\nUser-Agent: TraceReplayer");
+    request.set_size(record.size);
+    double cycles = record.serviceTime * cyclesPerSecond;
+    request.set_task_time(cycles < MAX_TASK_TIME ? std::max(1, (int) std::ceil(cycles)) : (int) MAX_TASK_TIME);
+    return request;
+}
+
+/**
+ * @brief Replays the trace, distributing requests every cycle.
+ *
+ * Arrival cycles are measured from the first record's timestamp and from the cycle
+ * the LoadBalancer was at when the replay started. Every record due at or before
+ * the current cycle is enqueued before the cycle's distribute_requests() call.
+ *
+ * @param maxCycles Cycle limit; 0 or less replays until done.
+ * @return long long The number of requests replayed.
+ */
+long long TraceReplayer::run(int maxCycles) {
+    TraceRecord record;
+    bool pending = reader.next(record);
+    double startTime = record.timestamp;
+    int startCycle = lb.get_cycle();
+
+    for (int cycle = 0; maxCycles <= 0 || cycle < maxCycles; ++cycle) {
+        while (pending) {
+            double arrival = (record.timestamp - startTime) * cyclesPerSecond / speedup;
+            if (arrival > lb.get_cycle() - startCycle) break;
+            lb.add_request(make_request(record));
+            replayed++;
+            pending = reader.next(record);
+        }
+        if (!pending && lb.get_queue_size() == 0 && lb.get_in_flight_requests() == 0) break;
+        lb.distribute_requests();
+    }
+    return replayed;
+}
+
+/**
+ * @brief Gets the number of requests replayed so far.
+ *
+ * @return long long Replayed request count.
+ */
+long long TraceReplayer::get_replayed() const {
+    return replayed;
+}
@@ -0,0 +1,64 @@
+#ifndef TRACEREPLAYER_H
+#define TRACEREPLAYER_H
+#include "LoadBalancer.h"
+#include "TraceReader.h"
+
+/**
+ * @file TraceReplayer.h
+ * @brief Defines the TraceReplayer class, which feeds a recorded access log into a LoadBalancer.
+ *
+ * Trace timestamps are mapped onto simulation cycles, so a replay runs in virtual
+ * time as fast as the simulation allows instead of waiting out the recorded gaps.
+ */
+
+/**
+ * @class TraceReplayer
+ * @brief Replays a TraceReader's records into a LoadBalancer in virtual time.
+ *
+ * Only the next pending record is held in memory, so memory use does not grow with
+ * the length of the trace.
+ */
+class TraceReplayer {
+private:
+    LoadBalancer& lb;
+    TraceReader& reader;
+    double cyclesPerSecond;
+    double speedup;
+    long long replayed;
+
+    /**
+     * @brief Converts a trace record into a Request.
+     */
+    Request make_request(const TraceRecord& record) const;
+
+public:
+
+    /**
+     * @brief Constructs a TraceReplayer.
+     *
+     * @param lb The LoadBalancer to feed.
+     * @param reader An open trace.
+     * @param cyclesPerSecond Simulation cycles per second of recorded time.
+     * @param speedup Factor by which gaps between arrivals are compressed; 1 replays
+     *                the recorded load, 2 replays twice as many requests per cycle.
+     */
+    TraceReplayer(LoadBalancer& lb, TraceReader& reader, double cyclesPerSecond, double speedup);
+
+    /**
+     * @brief Replays the trace, distributing requests every cycle.
+     *
+     * Stops once the trace is exhausted and every request has finished, or after maxCycles.
+     *
+     * @param maxCycles Cycle limit; 0 or less replays until done.
+     * @return The number of requests replayed.
+     */
+    long long run(int maxCycles);
+
+    /**
+     * @brief Gets the number of requests replayed so far.
+     * @return Replayed request count.
+     */
+    long long get_replayed() const;
+};
+
+#endif
@@ -0,0 +1,235 @@
+/**
+ * @file Tracing.cpp
+ * @brief Implementation of the Tracer and TraceSpan classes.
+ *
+ * @see Tracer
+ *
+ */
+
+#include "Tracing.h"
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+/**
+ * @brief Per-thread sampling state: nesting depth and whether the current tree is sampled.
+ */
+struct TraceThreadState {
+    int depth = 0;
+    bool sampled = false;
+    long long outermost = 0;
+    void* buffer = nullptr;
+};
+
+static thread_local TraceThreadState traceState;
+
+/**
+ * @brief Constructs the tracer, disabled and recording every cycle.
+ */
+Tracer::Tracer()
+    : sampleEvery(1), dropped(0), maxEventsPerThread(1 << 20), ticksPerMicrosecond(1000.0),
+      origin(0) {}
+
+/**
+ * @brief Gets the process-wide tracer.
+ *
+ * @return Tracer& The tracer.
+ */
+Tracer& Tracer::global() {
+    static Tracer tracer;
+    return tracer;
+}
+
+/**
+ * @brief Starts recording spans and calibrates the timestamp counter.
+ *
+ * The counter is timed against the steady clock, so exported times are in real
+ * microseconds whatever the CPU frequency. Times are relative to the first enable().
+ *
+ * @param sampleEvery Record one cycle in this many; 1 records all.
+ * @param maxEventsPerThread Spans kept per thread before further spans are dropped.
+ */
+void Tracer::enable(int sampleEvery, size_t maxEventsPerThread) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        this->sampleEvery = sampleEvery > 0 ? sampleEvery : 1;
+        this->maxEventsPerThread = maxEventsPerThread;
+
+        auto wallStart = std::chrono::steady_clock::now();
+        uint64_t ticksStart = trace_clock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t ticks = trace_clock() - ticksStart;
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - wallStart).count();
+        if (ticks > 0 && micros > 0.0) ticksPerMicrosecond = ticks / micros;
+        if (origin == 0) origin = ticksStart;
+    }
+    enabled = true;
+}
+
+/**
+ * @brief Stops recording spans; recorded spans are kept until clear().
+ */
+void Tracer::disable() {
+    enabled = false;
+}
+
+/**
+ * @brief Gets the sample rate.
+ *
+ * @return int One cycle in this many is recorded.
+ */
+int Tracer::get_sample_every() const {
+    return sampleEvery.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the calling thread's buffer, registering it on first use.
+ *
+ * Buffers are never freed before the tracer, so the cached pointer stays valid.
+ *
+ * @return ThreadBuffer& The buffer.
+ */
+Tracer::ThreadBuffer& Tracer::thread_buffer() {
+    if (!traceState.buffer) {
+        std::lock_guard<std::mutex> guard(lock);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffers.back()->tid = buffers.size();
+        traceState.buffer = buffers.back().get();
+    }
+    return *static_cast<ThreadBuffer*>(traceState.buffer);
+}
+
+/**
+ * @brief Records a finished span on the calling thread.
+ *
+ * The buffer lock is only ever contended by an export or clear().
+ *
+ * @param name Span name.
+ * @param start Start time from trace_clock().
+ * @param end End time from trace_clock().
+ */
+void Tracer::record(const char* name, uint64_t start, uint64_t end) {
+    ThreadBuffer& buffer = thread_buffer();
+    std::lock_guard<std::mutex> guard(buffer.lock);
+    if (buffer.events.size() >= maxEventsPerThread) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events.push_back({name, start, end});
+}
+
+/**
+ * @brief Gets the number of spans dropped because a thread's buffer was full.
+ *
+ * @return long long Dropped span count.
+ */
+long long Tracer::get_dropped() const {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Gets the number of spans recorded and not yet cleared.
+ *
+ * @return size_t Recorded span count.
+ */
+size_t Tracer::get_event_count() {
+    std::lock_guard<std::mutex> guard(lock);
+    size_t total = 0;
+    for (std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+        std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+        total += buffer->events.size();
+    }
+    return total;
+}
+
+/**
+ * @brief Discards every recorded span.
+ */
+void Tracer::clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    for (std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+        std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+        buffer->events.clear();
+    }
+    dropped = 0;
+}
+
+/**
+ * @brief Writes a span name as a JSON string.
+ */
+static void write_json_string(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        out << *c;
+    }
+    out << '"';
+}
+
+/**
+ * @brief Writes every recorded span as Chrome trace-event JSON.
+ *
+ * Spans become complete ("X") events with times in microseconds; each thread is
+ * named by a metadata event.
+ *
+ * @param out Destination stream.
+ */
+void Tracer::write_chrome_trace(std::ostream& out) {
+    std::lock_guard<std::mutex> guard(lock);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+        std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+        out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"thread " << buffer->tid << "\"}}";
+        first = false;
+        for (const Event& event : buffer->events) {
+            out << ",\n{\"name\":";
+            write_json_string(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << (event.start - origin) / ticksPerMicrosecond
+                << ",\"dur\":" << (event.end - event.start) / ticksPerMicrosecond << "}";
+        }
+    }
+    out << "\n]}\n";
+}
+
+/**
+ * @brief Writes every recorded span to a Chrome trace-event JSON file.
+ *
+ * @param path Destination file.
+ * @return true On success.
+ */
+bool Tracer::write_chrome_trace(const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) return false;
+    out.precision(15);
+    write_chrome_trace(out);
+    out.flush();
+    return (bool) out;
+}
+
+/**
+ * @brief Opens a span while tracing is enabled.
+ *
+ * The outermost span of a thread decides whether its whole tree is sampled: by
+ * its cycle when it has one, so all spans of a cycle share the decision, and
+ * otherwise by counting outermost spans.
+ *
+ * @param cycle Simulation cycle of the span, or -1.
+ * @return true If the span should be recorded.
+ */
+bool TraceSpan::begin(long long cycle) {
+    if (traceState.depth++ == 0) {
+        long long key = cycle >= 0 ? cycle : traceState.outermost++;
+        traceState.sampled = key % Tracer::global().get_sample_every() == 0;
+    }
+    return traceState.sampled;
+}
+
+/**
+ * @brief Closes a span opened by begin().
+ */
+void TraceSpan::end() {
+    traceState.depth--;
+}
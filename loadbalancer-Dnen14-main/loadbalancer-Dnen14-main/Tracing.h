@@ -0,0 +1,233 @@
+#ifndef TRACING_H
+#define TRACING_H
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * @file Tracing.h
+ * @brief Defines the Tracer and TraceSpan classes, a low-overhead scope profiler with Chrome trace export.
+ *
+ * A TraceSpan placed at the top of a scope records how long the scope took, using
+ * the CPU timestamp counter. Spans are buffered per thread and written out in the
+ * Chrome trace-event format, which chrome://tracing and Perfetto open directly.
+ *
+ * Sampling is decided at the outermost span of each thread and covers everything
+ * nested inside it, so a sampled trace still shows complete call trees. An
+ * outermost span opened with a simulation cycle is recorded when the cycle is a
+ * multiple of the sample rate N, so every span of one cycle in N is kept together
+ * however many requests arrive in it; an outermost span without a cycle falls
+ * back to one in N such spans. While tracing is disabled a span costs one relaxed
+ * load and a branch.
+ */
+
+/**
+ * @brief Reads the timestamp counter.
+ *
+ * @return Ticks of the CPU timestamp counter, or nanoseconds where there is none.
+ */
+inline uint64_t trace_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @class Tracer
+ * @brief Collects spans from every thread and exports them as a Chrome trace.
+ */
+class Tracer {
+private:
+
+    /**
+     * @brief One recorded span.
+     */
+    struct Event {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    /**
+     * @brief The spans recorded by one thread.
+     */
+    struct ThreadBuffer {
+        std::mutex lock;
+        std::vector<Event> events;
+        int tid;
+    };
+
+    static inline std::atomic<bool> enabled{false};
+    std::atomic<int> sampleEvery;
+    std::atomic<long long> dropped;
+    size_t maxEventsPerThread;
+    double ticksPerMicrosecond;
+    uint64_t origin;
+    std::mutex lock;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    /**
+     * @brief Gets the calling thread's buffer, registering it on first use.
+     */
+    ThreadBuffer& thread_buffer();
+
+    /**
+     * @brief Constructs the tracer; private because per-thread buffers are cached
+     * for a single instance, reached through global().
+     */
+    Tracer();
+
+public:
+
+    /**
+     * @brief Gets the process-wide tracer.
+     *
+     * @return The tracer.
+     */
+    static Tracer& global();
+
+    /**
+     * @brief Starts recording spans and calibrates the timestamp counter.
+     *
+     * Calibration sleeps for about 20 ms.
+     *
+     * @param sampleEvery Record one cycle in this many; 1 records all.
+     * @param maxEventsPerThread Spans kept per thread before further spans are dropped.
+     */
+    void enable(int sampleEvery = 1, size_t maxEventsPerThread = 1 << 20);
+
+    /**
+     * @brief Stops recording spans; recorded spans are kept until clear().
+     */
+    void disable();
+
+    /**
+     * @brief Checks whether spans are being recorded.
+     *
+     * @return True while enabled.
+     */
+    static bool is_enabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Gets the sample rate.
+     *
+     * @return One cycle in this many is recorded.
+     */
+    int get_sample_every() const;
+
+    /**
+     * @brief Records a finished span on the calling thread.
+     *
+     * @param name Span name; must outlive the tracer, e.g. a string literal.
+     * @param start Start time from trace_clock().
+     * @param end End time from trace_clock().
+     */
+    void record(const char* name, uint64_t start, uint64_t end);
+
+    /**
+     * @brief Gets the number of spans dropped because a thread's buffer was full.
+     *
+     * @return Dropped span count.
+     */
+    long long get_dropped() const;
+
+    /**
+     * @brief Gets the number of spans recorded and not yet cleared.
+     *
+     * @return Recorded span count.
+     */
+    size_t get_event_count();
+
+    /**
+     * @brief Discards every recorded span.
+     */
+    void clear();
+
+    /**
+     * @brief Writes every recorded span as Chrome trace-event JSON.
+     *
+     * @param out Destination stream.
+     */
+    void write_chrome_trace(std::ostream& out);
+
+    /**
+     * @brief Writes every recorded span to a Chrome trace-event JSON file.
+     *
+     * @param path Destination file.
+     * @return True on success.
+     */
+    bool write_chrome_trace(const std::string& path);
+};
+
+/**
+ * @class TraceSpan
+ * @brief Times the enclosing scope and records it with the global Tracer.
+ *
+ *     void LoadBalancer::distribute_requests() {
+ *         TraceSpan span("LoadBalancer::distribute_requests", count);
+ *         ...
+ *     }
+ */
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t start;
+    bool active;
+
+    /**
+     * @brief Opens a span while tracing is enabled; returns whether it is sampled.
+     */
+    static bool begin(long long cycle);
+
+    /**
+     * @brief Closes a span opened by begin().
+     */
+    static void end();
+
+public:
+
+    /**
+     * @brief Opens a span.
+     *
+     * @param name Span name; must outlive the tracer, e.g. a string literal.
+     * @param cycle Simulation cycle the span belongs to, which decides sampling when
+     * this is the outermost span; -1 to sample by span count instead.
+     */
+    explicit TraceSpan(const char* name, long long cycle = -1) : name(name), start(0), active(false) {
+        if (!Tracer::is_enabled()) return;
+        active = true;
+        if (begin(cycle)) {
+            start = trace_clock();
+        } else {
+            this->name = nullptr;
+        }
+    }
+
+    /**
+     * @brief Closes the span and records it if it was sampled.
+     */
+    ~TraceSpan() {
+        if (!active) return;
+        if (name) Tracer::global().record(name, start, trace_clock());
+        end();
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#endif
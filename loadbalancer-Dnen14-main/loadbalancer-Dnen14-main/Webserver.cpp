@@ -1,4 +1,10 @@
 #include "Webserver.h"
+#include "utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
 
 /**
  * @file Webserver.cpp
@@ -27,6 +33,47 @@
  * It includes methods to simulate the start and stop operations.
  */
 
+bool parse_instance_type(const std::string& spec, InstanceType& type) {
+    size_t colon = spec.find(':');
+    if (colon == 0 || colon == std::string::npos) return false;
+    std::vector<double> fields;
+    size_t start = colon + 1;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string field = spec.substr(start, end - start);
+        char* parsedEnd = nullptr;
+        errno = 0;
+        double value = std::strtod(field.c_str(), &parsedEnd);
+        if (field.empty() || *parsedEnd != '\0' || errno != 0 || !std::isfinite(value) || value < 0.0) return false;
+        fields.push_back(value);
+        start = end + 1;
+    }
+    if (fields.size() < 2 || fields.size() > 4 || fields[0] <= 0.0 || fields[1] < 1.0 || fields[1] > INT_MAX
+        || fields[1] != std::floor(fields[1])) {
+        return false;
+    }
+    if (fields.size() > 2 && (fields[2] >= (double) LLONG_MAX || fields[2] != std::floor(fields[2]))) return false;
+
+    type.name = spec.substr(0, colon);
+    type.speed = fields[0];
+    type.slots = (int) fields[1];
+    type.memory = fields.size() > 2 ? (long long) fields[2] : 0;
+    type.cost = fields.size() > 3 ? fields[3] : type.speed * type.slots;
+    return true;
+}
+
+/**
+ * @brief Checks an instance type against the rules parse_instance_type() enforces.
+ *
+ * @param type The type to check.
+ * @return bool True if the type is valid.
+ */
+bool is_valid_instance_type(const InstanceType& type) {
+    return std::isfinite(type.speed) && type.speed > 0.0 && type.slots >= 1 && type.memory >= 0
+        && std::isfinite(type.cost) && type.cost >= 0.0;
+}
+
 /**
  * @brief Constructs a WebServer object with a specified port.
  * 
@@ -45,6 +92,14 @@ WebServer::WebServer(){
     this->port = 8080;
 }
 
+/**
+ * @brief Constructs a WebServer of a given instance type.
+ *
+ * @param port The port number the web server will use.
+ * @param type The server's capacity and price.
+ */
+WebServer::WebServer(int port, const InstanceType& type) : port(port), type(type) {}
+
 /**
  * @brief Destructor for WebServer.
  * 
@@ -85,4 +140,255 @@ void WebServer::set_port(int value){
  */
 int WebServer::get_port(){
     return port;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Serves one cycle of work for a request.
+ *
+ * A server that is down always fails. Otherwise the call fails with probability
+ * failureRate; the random draw is skipped entirely for healthy servers so the
+ * random sequence is unaffected when no faults are configured.
+ *
+ * @param latency Set to the observed latency of the call, in cycles.
+ * @param rng Random source for injected failures.
+ * @return true If the call succeeded.
+ * @return false If the call failed.
+ */
+bool WebServer::serve(int& latency, Rng& rng){
+    latency = 1 + extraLatency;
+    if (down) return false;
+    if (failureRate > 0.0 && rng.bernoulli(failureRate)) return false;
+    return true;
+}
+
+/**
+ * @brief Answers an active health probe.
+ *
+ * @return true If the server is up.
+ */
+bool WebServer::probe() const {
+    return !down;
+}
+
+/**
+ * @brief Marks the server as down or back up.
+ *
+ * @param value True to take the server down.
+ */
+void WebServer::set_down(bool value){
+    down = value;
+}
+
+/**
+ * @brief Sets the probability that a call to serve() fails.
+ *
+ * @param rate Failure probability in [0, 1].
+ */
+void WebServer::set_failure_rate(double rate){
+    failureRate = rate;
+}
+
+/**
+ * @brief Sets the additional latency this server adds to every call.
+ *
+ * @param cycles Extra latency, in cycles; negative values are treated as 0.
+ */
+void WebServer::set_extra_latency(int cycles){
+    extraLatency = std::max(0, cycles);
+}
+
+/**
+ * @brief Gets the health bookkeeping for this server.
+ *
+ * @return ServerHealth& The server's health state.
+ */
+ServerHealth& WebServer::get_health(){
+    return health;
+}
+
+/**
+ * @brief Gets the server's instance type.
+ *
+ * @return const InstanceType& The server's capacity and price.
+ */
+const InstanceType& WebServer::get_type() const {
+    return type;
+}
+
+/**
+ * @brief Gets the work the server does per cycle after its extra latency.
+ *
+ * A call that takes 1 + extraLatency cycles delivers one cycle of work, so the
+ * work is spread evenly over those cycles.
+ *
+ * @return double The effective speed.
+ */
+double WebServer::get_effective_speed() const {
+    return type.speed / (1 + extraLatency);
+}
+
+/**
+ * @brief Checks whether a request can start on this server now.
+ *
+ * @param request The request to place.
+ * @return true If a slot is free and, when memory is limited, the request's
+ * response fits beside those already in flight.
+ */
+bool WebServer::can_accept(const Request& request) const {
+    if ((int) requests.size() >= type.slots) return false;
+    if (type.memory <= 0) return true;
+    long long used = request.get_size();
+    for (const Request& inFlight : requests) used += inFlight.get_size();
+    return used <= type.memory;
+}
+
+/**
+ * @brief Starts a request on this server.
+ *
+ * @param request The request to start.
+ */
+void WebServer::assign(Request request) {
+    requests.push_back(std::move(request));
+}
+
+/**
+ * @brief Gets the requests in flight on this server.
+ *
+ * @return std::vector<Request>& The in-flight requests.
+ */
+std::vector<Request>& WebServer::get_requests() {
+    return requests;
+}
+
+/**
+ * @brief Gets the number of requests in flight.
+ *
+ * @return int The number of busy slots.
+ */
+int WebServer::get_in_flight() const {
+    return requests.size();
+}
+
+/**
+ * @brief Gets the number of slots not serving a request.
+ *
+ * @return int Free slots, or 0 if the server is draining and takes no new requests.
+ */
+int WebServer::get_free_slots() const {
+    if (is_draining()) return 0;
+    return std::max(0, type.slots - (int) requests.size());
+}
+
+/**
+ * @brief Estimates when a request would finish if sent to this server now.
+ *
+ * @param request The request to place.
+ * @return double The cycles to wait for a slot plus the request's task time
+ * scaled by the server's effective speed.
+ */
+double WebServer::expected_completion(const Request& request) const {
+    double wait = 0.0;
+    if (!can_accept(request) && !requests.empty()) {
+        int shortest = requests.front().get_task_time();
+        for (const Request& inFlight : requests) shortest = std::min(shortest, inFlight.get_task_time());
+        wait = shortest / get_effective_speed();
+    }
+    return wait + request.get_task_time() / get_effective_speed();
+}
+
+/**
+ * @brief Estimates how long the server needs to finish its in-flight requests.
+ *
+ * @return double The remaining task time of every in-flight request, scaled by the server's effective speed.
+ */
+double WebServer::get_remaining_work() const {
+    double work = 0.0;
+    for (const Request& request : requests) work += request.get_task_time();
+    return work / get_effective_speed();
+}
+
+/**
+ * @brief Takes the server out of rotation so it can be released once idle.
+ *
+ * @param cycle The cycle the drain starts.
+ */
+void WebServer::start_draining(int cycle) {
+    drainingSince = cycle;
+}
+
+/**
+ * @brief Puts a draining server back in rotation.
+ */
+void WebServer::stop_draining() {
+    drainingSince = -1;
+}
+
+/**
+ * @brief Checks whether the server is draining.
+ *
+ * @return true If the server takes no new requests.
+ */
+bool WebServer::is_draining() const {
+    return drainingSince >= 0;
+}
+
+/**
+ * @brief Gets the cycle the server started draining.
+ *
+ * @return int The cycle, or -1 if the server is not draining.
+ */
+int WebServer::get_draining_since() const {
+    return drainingSince;
+}
+
+/**
+ * @brief Writes the server's configuration, health state and in-flight requests to a binary snapshot.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void WebServer::save(std::ostream& out) const {
+    write_value(out, port);
+    write_value(out, down);
+    write_value(out, failureRate);
+    write_value(out, extraLatency);
+    write_value(out, health.consecutiveFailures);
+    write_value(out, health.ejections);
+    write_value(out, health.ejectedUntil);
+    write_value(out, health.ejected);
+    write_value(out, health.samples);
+    write_value(out, health.latencyEwma);
+    write_string(out, type.name);
+    write_value(out, type.speed);
+    write_value(out, type.slots);
+    write_value(out, type.memory);
+    write_value(out, type.cost);
+    write_value(out, drainingSince);
+    write_value<uint32_t>(out, requests.size());
+    for (const Request& request : requests) {
+        request.save(out);
+    }
+}
+
+/**
+ * @brief Restores state written by save().
+ *
+ * @param in Stream opened in binary mode.
+ * @return true On success.
+ */
+bool WebServer::restore(std::istream& in) {
+    uint32_t inFlight = 0;
+    if (!read_value(in, port) || !read_value(in, down) || !read_value(in, failureRate)
+        || !read_value(in, extraLatency) || extraLatency < 0 || !read_value(in, health.consecutiveFailures)
+        || !read_value(in, health.ejections) || !read_value(in, health.ejectedUntil) || !read_value(in, health.ejected)
+        || !read_value(in, health.samples) || !read_value(in, health.latencyEwma) || !read_string(in, type.name)
+        || !read_value(in, type.speed) || !read_value(in, type.slots) || !read_value(in, type.memory)
+        || !read_value(in, type.cost) || !read_value(in, drainingSince) || !read_value(in, inFlight)
+        || !is_valid_instance_type(type) || !stream_has(in, (uint64_t) inFlight * Request::MIN_SNAPSHOT_BYTES)) {
+        return false;
+    }
+    requests.assign(inFlight, Request());
+    for (Request& request : requests) {
+        if (!request.restore(in)) return false;
+    }
+    return true;
+}
@@ -1,6 +1,10 @@
 #ifndef WEBSERVER_H
 #define WEBSERVER_H
 #include <iostream>
+#include <string>
+#include <vector>
+#include "Random.h"
+#include "Request.h"
 
 /**
  * @file Webserver.h
@@ -12,6 +16,63 @@
  * for setting and retrieving the server port.
  */
 
+/**
+ * @struct ServerHealth
+ * @brief Health bookkeeping the HealthChecker keeps for a single WebServer.
+ *
+ * Latency is tracked as an exponentially weighted moving average so a single slow
+ * response does not eject a server, while a consistently slow one stands out.
+ */
+struct ServerHealth {
+    int consecutiveFailures = 0;
+    int ejections = 0;
+    int ejectedUntil = 0;
+    bool ejected = false;
+    int samples = 0;
+    double latencyEwma = 0.0;
+};
+
+/**
+ * @struct InstanceType
+ * @brief The capacity and price of a kind of server.
+ *
+ * Speed is work done per cycle relative to a standard server, so a request's task
+ * time is its cost on a standard server. Each slot serves one request at full
+ * speed; memory bounds the total response size of the requests in flight.
+ */
+struct InstanceType {
+    std::string name = "standard";
+    double speed = 1.0;
+    int slots = 1;
+    long long memory = 0;
+    double cost = 1.0;
+};
+
+/**
+ * @brief Parses an instance type spec such as "large:2,4" or "old:0.5,1,65536,0.3".
+ *
+ * The fields after the name are speed, slots, memory in bytes (0 for unlimited)
+ * and cost per cycle. Memory and cost are optional; the cost defaults to
+ * speed * slots, i.e. capacity is priced linearly. Every field must be finite
+ * and non-negative, speed positive, and slots and memory whole numbers.
+ *
+ * @param spec The spec string.
+ * @param type Set to the parsed type.
+ * @return True if the spec is valid.
+ */
+bool parse_instance_type(const std::string& spec, InstanceType& type);
+
+/**
+ * @brief Checks an instance type against the rules parse_instance_type() enforces.
+ *
+ * Used on types that did not come from a spec, such as those read from a snapshot.
+ *
+ * @param type The type to check.
+ * @return True if speed is finite and positive, slots at least one, memory
+ *         non-negative and cost finite and non-negative.
+ */
+bool is_valid_instance_type(const InstanceType& type);
+
 /**
  * @class WebServer
  * @brief A class that simulates a web server instance.
@@ -22,6 +83,13 @@
 class WebServer {
 private:
     int port;
+    bool down = false;
+    double failureRate = 0.0;
+    int extraLatency = 0;
+    ServerHealth health;
+    InstanceType type;
+    std::vector<Request> requests;
+    int drainingSince = -1;
 
 public:
 
@@ -36,6 +104,13 @@ public:
      */
     WebServer();
 
+    /**
+     * @brief Constructs a WebServer of a given instance type.
+     * @param port The port number for the web server.
+     * @param type The server's capacity and price.
+     */
+    WebServer(int port, const InstanceType& type);
+
     /**
      * @brief Destroys the WebServer object.
      */
@@ -62,6 +137,150 @@ public:
      * @return The current port number.
      */
     int get_port();
+
+    /**
+     * @brief Serves one cycle of work for a request.
+     *
+     * A server that is down always fails; otherwise the call fails with the
+     * configured failure rate.
+     *
+     * @param latency Set to the observed latency of the call, in cycles.
+     * @param rng Random source for injected failures.
+     * @return True if the call succeeded, false otherwise.
+     */
+    bool serve(int& latency, Rng& rng);
+
+    /**
+     * @brief Answers an active health probe.
+     * @return True if the server is up.
+     */
+    bool probe() const;
+
+    /**
+     * @brief Marks the server as down or back up (used to simulate outages).
+     * @param value True to take the server down.
+     */
+    void set_down(bool value);
+
+    /**
+     * @brief Sets the probability that a call to serve() fails.
+     * @param rate Failure probability in [0, 1].
+     */
+    void set_failure_rate(double rate);
+
+    /**
+     * @brief Sets the additional latency this server adds to every call.
+     *
+     * Each call then takes 1 + cycles cycles, so the server also makes
+     * proportionally less progress per cycle; see get_effective_speed().
+     *
+     * @param cycles Extra latency, in cycles; negative values are treated as 0.
+     */
+    void set_extra_latency(int cycles);
+
+    /**
+     * @brief Gets the health bookkeeping for this server.
+     * @return A reference to the server's health state.
+     */
+    ServerHealth& get_health();
+
+    /**
+     * @brief Gets the server's instance type.
+     * @return The server's capacity and price.
+     */
+    const InstanceType& get_type() const;
+
+    /**
+     * @brief Gets the work the server does per cycle after its extra latency.
+     * @return The type's speed divided by the cycles each call takes.
+     */
+    double get_effective_speed() const;
+
+    /**
+     * @brief Checks whether a request can start on this server now.
+     * @param request The request to place.
+     * @return True if a slot is free and the request fits in the remaining memory.
+     */
+    bool can_accept(const Request& request) const;
+
+    /**
+     * @brief Starts a request on this server.
+     * @param request The request; the caller checks can_accept() first.
+     */
+    void assign(Request request);
+
+    /**
+     * @brief Gets the requests in flight on this server.
+     * @return The in-flight requests, which the LoadBalancer serves and removes.
+     */
+    std::vector<Request>& get_requests();
+
+    /**
+     * @brief Gets the number of requests in flight.
+     * @return The number of busy slots.
+     */
+    int get_in_flight() const;
+
+    /**
+     * @brief Gets the number of slots not serving a request.
+     * @return Free slots; 0 while draining.
+     */
+    int get_free_slots() const;
+
+    /**
+     * @brief Estimates when a request would finish if sent to this server now.
+     *
+     * A request that cannot start yet first waits for the earliest in-flight
+     * request to finish.
+     *
+     * @param request The request to place.
+     * @return Expected cycles until completion.
+     */
+    double expected_completion(const Request& request) const;
+
+    /**
+     * @brief Estimates how long the server needs to finish its in-flight requests.
+     * @return The remaining task time of every in-flight request, scaled by the server's effective speed.
+     */
+    double get_remaining_work() const;
+
+    /**
+     * @brief Takes the server out of rotation so it can be released once idle.
+     * @param cycle The cycle the drain starts.
+     */
+    void start_draining(int cycle);
+
+    /**
+     * @brief Puts a draining server back in rotation.
+     */
+    void stop_draining();
+
+    /**
+     * @brief Checks whether the server is draining.
+     * @return True if the server takes no new requests.
+     */
+    bool is_draining() const;
+
+    /**
+     * @brief Gets the cycle the server started draining.
+     * @return The cycle, or -1 if the server is not draining.
+     */
+    int get_draining_since() const;
+
+    /**
+     * @brief Writes the server's configuration and health state to a binary snapshot.
+     *
+     * @param out Stream opened in binary mode.
+     */
+    void save(std::ostream& out) const;
+
+    /**
+     * @brief Restores state written by save().
+     *
+     * @param in Stream opened in binary mode.
+     * @return True on success.
+     */
+    bool restore(std::istream& in);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,506 @@
+/**
+ * @file Workload.cpp
+ * @brief Implementation of the arrival processes, service time distributions and Workload class.
+ *
+ * Every distribution is derived from Rng::uniform() and Rng::normal() by inverse
+ * transform rather than from <random>, whose distributions are not guaranteed to
+ * produce the same sequence across standard library implementations.
+ *
+ * @see Workload
+ * @see Rng
+ *
+ */
+
+#include "Workload.h"
+#include "utils.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+/** Largest task time a heavy-tailed sample is clamped to, in cycles. */
+static const double MAX_TASK_TIME = 1e9;
+
+/** Pi, spelled out because M_PI is not part of standard C++. */
+static const double PI = 3.14159265358979323846;
+
+/**
+ * @brief Rounds a continuous task time up to whole cycles, at least 1.
+ *
+ * @param value Sampled task time.
+ * @return int Task time in cycles.
+ */
+static int to_cycles(double value) {
+    if (!(value < MAX_TASK_TIME)) return (int) MAX_TASK_TIME;
+    return std::max(1, (int) std::ceil(value));
+}
+
+/**
+ * @brief Checks that a spec argument can be converted to int without overflow.
+ *
+ * @param value The argument.
+ * @return bool True if value lies within the range of int.
+ */
+static bool fits_int(double value) {
+    return value >= (double) INT_MIN && value <= (double) INT_MAX;
+}
+
+/**
+ * @brief Draws a Poisson-distributed count.
+ *
+ * @param mean Mean of the distribution; 0 or less always gives 0.
+ * @param rng Random source.
+ * @return int The sampled count, at most INT_MAX.
+ */
+int sample_poisson(double mean, Rng& rng) {
+    if (mean <= 0.0) return 0;
+    if (mean > 30.0) {
+        double value = std::round(mean + std::sqrt(mean) * rng.normal());
+        return value < 0.0 ? 0 : (int) std::min(value, (double) INT_MAX);
+    }
+    double limit = std::exp(-mean);
+    double product = rng.uniform();
+    int count = 0;
+    while (product > limit) {
+        product *= rng.uniform();
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Writes nothing; stateless processes have no state to save.
+ */
+void ArrivalProcess::save(std::ostream&) const {}
+
+/**
+ * @brief Reads nothing; stateless processes have no state to restore.
+ *
+ * @return bool Always true.
+ */
+bool ArrivalProcess::restore(std::istream&) {
+    return true;
+}
+
+/**
+ * @brief Constructs a process with at most one arrival per cycle.
+ *
+ * @param probability Chance of an arrival in each cycle.
+ */
+BernoulliArrivals::BernoulliArrivals(double probability) : probability(probability) {}
+
+/**
+ * @brief Draws whether a request arrives this cycle.
+ *
+ * @param rng Random source.
+ * @return int 1 with the configured probability, otherwise 0.
+ */
+int BernoulliArrivals::arrivals(int, Rng& rng) {
+    return rng.bernoulli(probability) ? 1 : 0;
+}
+
+/**
+ * @brief Constructs a Poisson process.
+ *
+ * @param rate Mean arrivals per cycle.
+ */
+PoissonArrivals::PoissonArrivals(double rate) : rate(rate) {}
+
+/**
+ * @brief Draws the number of arrivals in a cycle.
+ *
+ * @param rng Random source.
+ * @return int A Poisson count with the configured mean.
+ */
+int PoissonArrivals::arrivals(int, Rng& rng) {
+    return sample_poisson(rate, rng);
+}
+
+/**
+ * @brief Constructs a two-state Markov-modulated Poisson process, starting calm.
+ *
+ * @param calmRate Mean arrivals per cycle in the calm state.
+ * @param burstRate Mean arrivals per cycle in the burst state.
+ * @param toBurst Chance per cycle of switching from calm to burst.
+ * @param toCalm Chance per cycle of switching from burst to calm.
+ */
+MmppArrivals::MmppArrivals(double calmRate, double burstRate, double toBurst, double toCalm)
+    : calmRate(calmRate), burstRate(burstRate), toBurst(toBurst), toCalm(toCalm), bursting(false) {}
+
+/**
+ * @brief Possibly switches state, then draws arrivals at the current state's rate.
+ *
+ * @param rng Random source.
+ * @return int Number of arrivals.
+ */
+int MmppArrivals::arrivals(int, Rng& rng) {
+    if (rng.bernoulli(bursting ? toCalm : toBurst)) bursting = !bursting;
+    return sample_poisson(bursting ? burstRate : calmRate, rng);
+}
+
+/**
+ * @brief Writes the current state to a binary snapshot.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void MmppArrivals::save(std::ostream& out) const {
+    write_value(out, bursting);
+}
+
+/**
+ * @brief Restores the state written by save().
+ *
+ * @param in Stream opened in binary mode.
+ * @return bool True on success.
+ */
+bool MmppArrivals::restore(std::istream& in) {
+    return read_value(in, bursting);
+}
+
+/**
+ * @brief Constructs a Poisson process whose rate follows a sine wave.
+ *
+ * @param meanRate Rate averaged over a period.
+ * @param amplitude Relative swing of the rate around the mean.
+ * @param period Cycles per wave; values below 1 are raised to 1.
+ */
+DiurnalArrivals::DiurnalArrivals(double meanRate, double amplitude, int period)
+    : meanRate(meanRate), amplitude(amplitude), period(std::max(1, period)) {}
+
+/**
+ * @brief Draws arrivals at the rate for this cycle's position in the period.
+ *
+ * @param cycle The current simulation cycle.
+ * @param rng Random source.
+ * @return int Number of arrivals.
+ */
+int DiurnalArrivals::arrivals(int cycle, Rng& rng) {
+    double phase = 2.0 * PI * (cycle % period) / period;
+    return sample_poisson(meanRate * (1.0 + amplitude * std::sin(phase)), rng);
+}
+
+/**
+ * @brief Constructs a process that replays recorded arrival cycles.
+ *
+ * @param arrivalCycles Cycle of each arrival, in any order.
+ */
+TraceArrivals::TraceArrivals(std::vector<int> arrivalCycles)
+    : arrivalCycles(std::move(arrivalCycles)), position(0) {
+    std::sort(this->arrivalCycles.begin(), this->arrivalCycles.end());
+}
+
+/**
+ * @brief Releases every recorded arrival due by a cycle.
+ *
+ * @param cycle The current simulation cycle.
+ * @return int Number of recorded arrivals at or before the cycle not yet released.
+ */
+int TraceArrivals::arrivals(int cycle, Rng&) {
+    int count = 0;
+    while (position < arrivalCycles.size() && arrivalCycles[position] <= cycle) {
+        position++;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Writes the replay position to a binary snapshot.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void TraceArrivals::save(std::ostream& out) const {
+    write_value<uint64_t>(out, position);
+}
+
+/**
+ * @brief Restores the replay position written by save().
+ *
+ * @param in Stream opened in binary mode.
+ * @return bool True on success.
+ */
+bool TraceArrivals::restore(std::istream& in) {
+    uint64_t saved = 0;
+    if (!read_value(in, saved)) return false;
+    position = std::min<size_t>(saved, arrivalCycles.size());
+    return true;
+}
+
+/**
+ * @brief Constructs a uniform task time distribution.
+ *
+ * @param minTime Smallest task time, in cycles.
+ * @param maxTime Largest task time, in cycles.
+ */
+UniformServiceTime::UniformServiceTime(int minTime, int maxTime) : minTime(minTime), maxTime(maxTime) {}
+
+/**
+ * @brief Draws a task time.
+ *
+ * @param rng Random source.
+ * @return int Task time in cycles, at least 1.
+ */
+int UniformServiceTime::sample(Rng& rng) {
+    return std::max(1, rng.uniform_int(minTime, maxTime));
+}
+
+/**
+ * @brief Constructs an exponential task time distribution.
+ *
+ * @param mean Mean task time, in cycles.
+ */
+ExponentialServiceTime::ExponentialServiceTime(double mean) : mean(mean) {}
+
+/**
+ * @brief Draws a task time by inverse transform.
+ *
+ * @param rng Random source.
+ * @return int Task time in cycles.
+ */
+int ExponentialServiceTime::sample(Rng& rng) {
+    return to_cycles(-mean * std::log(rng.uniform()));
+}
+
+/**
+ * @brief Constructs a log-normal task time distribution.
+ *
+ * @param mu Mean of the task time's logarithm.
+ * @param sigma Standard deviation of the task time's logarithm.
+ */
+LogNormalServiceTime::LogNormalServiceTime(double mu, double sigma) : mu(mu), sigma(sigma) {}
+
+/**
+ * @brief Draws a task time.
+ *
+ * @param rng Random source.
+ * @return int Task time in cycles.
+ */
+int LogNormalServiceTime::sample(Rng& rng) {
+    return to_cycles(std::exp(mu + sigma * rng.normal()));
+}
+
+/**
+ * @brief Constructs a Pareto task time distribution.
+ *
+ * @param scale Smallest task time, in cycles.
+ * @param shape Tail index.
+ */
+ParetoServiceTime::ParetoServiceTime(double scale, double shape) : scale(scale), shape(shape) {}
+
+/**
+ * @brief Draws a task time by inverse transform.
+ *
+ * @param rng Random source.
+ * @return int Task time in cycles, clamped to MAX_TASK_TIME.
+ */
+int ParetoServiceTime::sample(Rng& rng) {
+    return to_cycles(scale / std::pow(rng.uniform(), 1.0 / shape));
+}
+
+/**
+ * @brief Splits a spec such as "mmpp:0.01,0.2,0.01,0.05" into a name and numbers.
+ *
+ * @param spec The spec string.
+ * @param name Set to the part before the colon.
+ * @param args Set to the comma-separated numbers after the colon.
+ * @return true If every argument parsed as a finite number.
+ */
+static bool parse_spec(const string& spec, string& name, std::vector<double>& args) {
+    size_t colon = spec.find(':');
+    name = spec.substr(0, colon);
+    args.clear();
+    if (colon == string::npos) return true;
+
+    size_t start = colon + 1;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == string::npos) end = spec.size();
+        string field = spec.substr(start, end - start);
+        char* parsedEnd = nullptr;
+        errno = 0;
+        double value = std::strtod(field.c_str(), &parsedEnd);
+        if (field.empty() || *parsedEnd != '\0' || errno != 0 || !std::isfinite(value)) return false;
+        args.push_back(value);
+        start = end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Loads arrival cycles from a text file, one integer per line.
+ *
+ * @param path File to read.
+ * @param cycles Set to the cycles read.
+ * @return true If the file could be opened.
+ */
+static bool load_arrival_cycles(const string& path, std::vector<int>& cycles) {
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+    int cycle;
+    while (in >> cycle) {
+        cycles.push_back(cycle);
+    }
+    return true;
+}
+
+/**
+ * @brief Builds an arrival process from a text spec.
+ *
+ * Rates must be non-negative, probabilities within [0, 1] and the diurnal period
+ * must fit in an int.
+ *
+ * @param spec The spec string.
+ * @return std::unique_ptr<ArrivalProcess> The process, or nullptr if the spec is invalid.
+ */
+std::unique_ptr<ArrivalProcess> make_arrival_process(const string& spec) {
+    if (spec.rfind("trace:", 0) == 0) {
+        std::vector<int> cycles;
+        if (!load_arrival_cycles(spec.substr(6), cycles)) return nullptr;
+        return std::make_unique<TraceArrivals>(std::move(cycles));
+    }
+
+    string name;
+    std::vector<double> args;
+    if (!parse_spec(spec, name, args)) return nullptr;
+    auto probability = [](double p) { return p >= 0.0 && p <= 1.0; };
+    if (name == "bernoulli" && args.size() == 1 && probability(args[0])) {
+        return std::make_unique<BernoulliArrivals>(args[0]);
+    } else if (name == "poisson" && args.size() == 1 && args[0] >= 0.0) {
+        return std::make_unique<PoissonArrivals>(args[0]);
+    } else if (name == "mmpp" && args.size() == 4 && args[0] >= 0.0 && args[1] >= 0.0 && probability(args[2])
+               && probability(args[3])) {
+        return std::make_unique<MmppArrivals>(args[0], args[1], args[2], args[3]);
+    } else if (name == "diurnal" && args.size() == 3 && args[0] >= 0.0 && fits_int(args[2])) {
+        return std::make_unique<DiurnalArrivals>(args[0], args[1], (int) args[2]);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Builds a service time distribution from a text spec.
+ *
+ * Uniform bounds must fit in an int, means and sigma must be non-negative and the
+ * Pareto scale and shape positive.
+ *
+ * @param spec The spec string.
+ * @return std::unique_ptr<ServiceTime> The distribution, or nullptr if the spec is invalid.
+ */
+std::unique_ptr<ServiceTime> make_service_time(const string& spec) {
+    string name;
+    std::vector<double> args;
+    if (!parse_spec(spec, name, args)) return nullptr;
+    if (name == "uniform" && args.size() == 2 && fits_int(args[0]) && fits_int(args[1])) {
+        return std::make_unique<UniformServiceTime>((int) args[0], (int) args[1]);
+    } else if (name == "exp" && args.size() == 1 && args[0] >= 0.0) {
+        return std::make_unique<ExponentialServiceTime>(args[0]);
+    } else if (name == "lognormal" && args.size() == 2 && args[1] >= 0.0) {
+        return std::make_unique<LogNormalServiceTime>(args[0], args[1]);
+    } else if (name == "pareto" && args.size() == 2 && args[0] > 0.0 && args[1] > 0.0) {
+        return std::make_unique<ParetoServiceTime>(args[0], args[1]);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Parses a request timeout: a fixed number of cycles or a distribution.
+ *
+ * @param spec A non-negative integer, or a spec accepted by make_service_time().
+ * @param cycles Set to the fixed timeout, or 0 when a distribution is given.
+ * @param distribution Set to the timeout distribution, or nullptr for a fixed timeout.
+ * @return bool True if the spec is valid.
+ */
+bool parse_timeout(const string& spec, int& cycles, std::unique_ptr<ServiceTime>& distribution) {
+    cycles = 0;
+    distribution.reset();
+    if (spec.find(':') != string::npos) {
+        distribution = make_service_time(spec);
+        return distribution != nullptr;
+    }
+    char* end = nullptr;
+    long value = std::strtol(spec.c_str(), &end, 10);
+    if (spec.empty() || *end != '\0' || value < 0 || value > INT_MAX) return false;
+    cycles = (int) value;
+    return true;
+}
+
+/**
+ * @brief Constructs a Workload.
+ *
+ * @param arrivalProcess How many requests arrive each cycle.
+ * @param serviceTime How long each request takes.
+ * @param seed Seed for the Workload's Rng.
+ */
+Workload::Workload(std::unique_ptr<ArrivalProcess> arrivalProcess, std::unique_ptr<ServiceTime> serviceTime,
+                   uint64_t seed)
+    : arrivalProcess(std::move(arrivalProcess)), serviceTime(std::move(serviceTime)), rng(seed) {}
+
+/**
+ * @brief Draws the number of requests arriving in a cycle.
+ *
+ * @param cycle The current simulation cycle.
+ * @return int Number of arrivals.
+ */
+int Workload::next_arrivals(int cycle) {
+    return arrivalProcess->arrivals(cycle, rng);
+}
+
+/**
+ * @brief Draws the task time of one request.
+ *
+ * @return int Task time in cycles.
+ */
+int Workload::next_task_time() {
+    return serviceTime->sample(rng);
+}
+
+/**
+ * @brief Gives each request a timeout drawn from a distribution.
+ *
+ * @param timeouts Timeout distribution, in cycles; nullptr for no per-request timeout.
+ */
+void Workload::set_timeouts(std::unique_ptr<ServiceTime> timeouts) {
+    this->timeouts = std::move(timeouts);
+}
+
+/**
+ * @brief Draws the timeout of one request.
+ *
+ * Nothing is drawn without a distribution, so the random stream of a run without
+ * per-request timeouts is unchanged.
+ *
+ * @return int Cycles the request may wait after arrival, or 0 if no timeout distribution is set.
+ */
+int Workload::next_timeout() {
+    return timeouts ? timeouts->sample(rng) : 0;
+}
+
+/**
+ * @brief Gets the Workload's random source.
+ *
+ * @return Rng& The Rng.
+ */
+Rng& Workload::get_rng() {
+    return rng;
+}
+
+/**
+ * @brief Writes the random state and arrival process state to a binary snapshot.
+ *
+ * @param out Stream opened in binary mode.
+ */
+void Workload::save(std::ostream& out) const {
+    rng.save(out);
+    arrivalProcess->save(out);
+}
+
+/**
+ * @brief Restores state written by save().
+ *
+ * @param in Stream opened in binary mode.
+ * @return true On success.
+ */
+bool Workload::restore(std::istream& in) {
+    return rng.restore(in) && arrivalProcess->restore(in);
+}
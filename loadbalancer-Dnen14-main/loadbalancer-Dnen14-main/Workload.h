@@ -0,0 +1,373 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+#include "Random.h"
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+using std::string;
+
+/**
+ * @file Workload.h
+ * @brief Defines the arrival processes and service time distributions used to generate traffic.
+ *
+ * A Workload pairs an ArrivalProcess, which decides how many requests arrive in each
+ * cycle, with a ServiceTime distribution, which decides how many cycles each request
+ * needs. Both draw from the Workload's own seeded Rng.
+ *
+ * Processes and distributions can be built from short text specs such as
+ * "poisson:0.05" or "pareto:1,1.5"; see make_arrival_process() and make_service_time().
+ */
+
+/**
+ * @class ArrivalProcess
+ * @brief Base class for request arrival processes.
+ */
+class ArrivalProcess {
+public:
+    virtual ~ArrivalProcess() = default;
+
+    /**
+     * @brief Draws the number of requests arriving in a cycle.
+     *
+     * Cycles are expected to be passed in increasing order.
+     *
+     * @param cycle The current simulation cycle.
+     * @param rng Random source.
+     * @return Number of arrivals.
+     */
+    virtual int arrivals(int cycle, Rng& rng) = 0;
+
+    /**
+     * @brief Writes any internal state to a binary snapshot.
+     *
+     * Stateless processes write nothing.
+     *
+     * @param out Stream opened in binary mode.
+     */
+    virtual void save(std::ostream& out) const;
+
+    /**
+     * @brief Restores state written by save().
+     *
+     * @param in Stream opened in binary mode.
+     * @return True on success.
+     */
+    virtual bool restore(std::istream& in);
+};
+
+/**
+ * @class BernoulliArrivals
+ * @brief At most one arrival per cycle, with a fixed probability (the original generator).
+ */
+class BernoulliArrivals : public ArrivalProcess {
+private:
+    double probability;
+
+public:
+    /**
+     * @param probability Chance of an arrival in each cycle.
+     */
+    explicit BernoulliArrivals(double probability);
+    int arrivals(int cycle, Rng& rng) override;
+};
+
+/**
+ * @class PoissonArrivals
+ * @brief Poisson arrivals with a constant mean rate per cycle.
+ */
+class PoissonArrivals : public ArrivalProcess {
+private:
+    double rate;
+
+public:
+    /**
+     * @param rate Mean arrivals per cycle.
+     */
+    explicit PoissonArrivals(double rate);
+    int arrivals(int cycle, Rng& rng) override;
+};
+
+/**
+ * @class MmppArrivals
+ * @brief Two-state Markov-modulated Poisson process for bursty traffic.
+ *
+ * The process alternates between a calm and a burst state; each cycle it switches
+ * state with the given probability and then draws Poisson arrivals at that state's rate.
+ */
+class MmppArrivals : public ArrivalProcess {
+private:
+    double calmRate;
+    double burstRate;
+    double toBurst;
+    double toCalm;
+    bool bursting;
+
+public:
+    /**
+     * @param calmRate Mean arrivals per cycle in the calm state.
+     * @param burstRate Mean arrivals per cycle in the burst state.
+     * @param toBurst Per-cycle probability of entering a burst.
+     * @param toCalm Per-cycle probability of leaving a burst.
+     */
+    MmppArrivals(double calmRate, double burstRate, double toBurst, double toCalm);
+    int arrivals(int cycle, Rng& rng) override;
+    void save(std::ostream& out) const override;
+    bool restore(std::istream& in) override;
+};
+
+/**
+ * @class DiurnalArrivals
+ * @brief Poisson arrivals whose rate follows a sinusoidal daily cycle.
+ */
+class DiurnalArrivals : public ArrivalProcess {
+private:
+    double meanRate;
+    double amplitude;
+    int period;
+
+public:
+    /**
+     * @param meanRate Mean arrivals per cycle averaged over a period.
+     * @param amplitude Relative swing around the mean, in [0, 1].
+     * @param period Length of one day, in cycles.
+     */
+    DiurnalArrivals(double meanRate, double amplitude, int period);
+    int arrivals(int cycle, Rng& rng) override;
+};
+
+/**
+ * @class TraceArrivals
+ * @brief Replays a recorded list of arrival cycles.
+ */
+class TraceArrivals : public ArrivalProcess {
+private:
+    std::vector<int> arrivalCycles;
+    size_t position;
+
+public:
+    /**
+     * @param arrivalCycles Cycle of each arrival; sorted on construction.
+     */
+    explicit TraceArrivals(std::vector<int> arrivalCycles);
+    int arrivals(int cycle, Rng& rng) override;
+    void save(std::ostream& out) const override;
+    bool restore(std::istream& in) override;
+};
+
+/**
+ * @class ServiceTime
+ * @brief Base class for service time distributions.
+ */
+class ServiceTime {
+public:
+    virtual ~ServiceTime() = default;
+
+    /**
+     * @brief Draws the task time of one request.
+     *
+     * @param rng Random source.
+     * @return Task time in cycles, at least 1.
+     */
+    virtual int sample(Rng& rng) = 0;
+};
+
+/**
+ * @class UniformServiceTime
+ * @brief Task times uniform in [min, max] (the original generator).
+ */
+class UniformServiceTime : public ServiceTime {
+private:
+    int minTime;
+    int maxTime;
+
+public:
+    UniformServiceTime(int minTime, int maxTime);
+    int sample(Rng& rng) override;
+};
+
+/**
+ * @class ExponentialServiceTime
+ * @brief Exponentially distributed task times.
+ */
+class ExponentialServiceTime : public ServiceTime {
+private:
+    double mean;
+
+public:
+    /**
+     * @param mean Mean task time, in cycles.
+     */
+    explicit ExponentialServiceTime(double mean);
+    int sample(Rng& rng) override;
+};
+
+/**
+ * @class LogNormalServiceTime
+ * @brief Log-normally distributed task times.
+ */
+class LogNormalServiceTime : public ServiceTime {
+private:
+    double mu;
+    double sigma;
+
+public:
+    /**
+     * @param mu Mean of the underlying normal distribution.
+     * @param sigma Standard deviation of the underlying normal distribution.
+     */
+    LogNormalServiceTime(double mu, double sigma);
+    int sample(Rng& rng) override;
+};
+
+/**
+ * @class ParetoServiceTime
+ * @brief Pareto (power-law) task times for heavy-tailed workloads.
+ */
+class ParetoServiceTime : public ServiceTime {
+private:
+    double scale;
+    double shape;
+
+public:
+    /**
+     * @param scale Smallest task time, in cycles.
+     * @param shape Tail index; values at or below 2 give infinite variance.
+     */
+    ParetoServiceTime(double scale, double shape);
+    int sample(Rng& rng) override;
+};
+
+/**
+ * @brief Draws a Poisson-distributed count.
+ *
+ * Uses Knuth's multiplication method for small means and a rounded normal
+ * approximation above 30.
+ *
+ * @param mean Mean of the distribution.
+ * @param rng Random source.
+ * @return The sampled count.
+ */
+int sample_poisson(double mean, Rng& rng);
+
+/**
+ * @brief Builds an arrival process from a text spec.
+ *
+ * Accepted specs: "bernoulli:p", "poisson:rate", "mmpp:calm,burst,toBurst,toCalm",
+ * "diurnal:mean,amplitude,period" and "trace:path" (one arrival cycle per line).
+ * Every number must be finite, rates non-negative and p, toBurst and toCalm
+ * within [0, 1].
+ *
+ * @param spec The spec string.
+ * @return The arrival process, or nullptr if the spec is invalid.
+ */
+std::unique_ptr<ArrivalProcess> make_arrival_process(const string& spec);
+
+/**
+ * @brief Builds a service time distribution from a text spec.
+ *
+ * Accepted specs: "uniform:min,max", "exp:mean", "lognormal:mu,sigma" and
+ * "pareto:scale,shape". Every number must be finite, the uniform bounds must fit
+ * in an int, mean and sigma must be non-negative and scale and shape positive.
+ *
+ * @param spec The spec string.
+ * @return The distribution, or nullptr if the spec is invalid.
+ */
+std::unique_ptr<ServiceTime> make_service_time(const string& spec);
+
+/**
+ * @brief Parses a request timeout: a fixed number of cycles or a distribution.
+ *
+ * A plain number gives every request the same timeout (0 for none); any spec
+ * accepted by make_service_time(), such as "uniform:10,60", draws a timeout per
+ * request, so deadlines no longer follow arrival order.
+ *
+ * @param spec The spec string.
+ * @param cycles Set to the fixed timeout, or 0 when a distribution is given.
+ * @param distribution Set to the timeout distribution, or nullptr for a fixed timeout.
+ * @return True if the spec is valid.
+ */
+bool parse_timeout(const string& spec, int& cycles, std::unique_ptr<ServiceTime>& distribution);
+
+/**
+ * @class Workload
+ * @brief Generates requests from an arrival process and a service time distribution.
+ *
+ * Each Workload owns its Rng, so independent simulations (for example on different
+ * threads) never share random state.
+ */
+class Workload {
+private:
+    std::unique_ptr<ArrivalProcess> arrivalProcess;
+    std::unique_ptr<ServiceTime> serviceTime;
+    std::unique_ptr<ServiceTime> timeouts;
+    Rng rng;
+
+public:
+
+    /**
+     * @brief Constructs a Workload.
+     *
+     * @param arrivalProcess How many requests arrive each cycle.
+     * @param serviceTime How long each request takes.
+     * @param seed Seed for the Workload's Rng.
+     */
+    Workload(std::unique_ptr<ArrivalProcess> arrivalProcess, std::unique_ptr<ServiceTime> serviceTime,
+             uint64_t seed);
+
+    /**
+     * @brief Draws the number of requests arriving in a cycle.
+     *
+     * @param cycle The current simulation cycle.
+     * @return Number of arrivals.
+     */
+    int next_arrivals(int cycle);
+
+    /**
+     * @brief Draws the task time of one request.
+     *
+     * @return Task time in cycles.
+     */
+    int next_task_time();
+
+    /**
+     * @brief Gives each request a timeout drawn from a distribution.
+     *
+     * @param timeouts Timeout distribution, in cycles; nullptr for no per-request timeout.
+     */
+    void set_timeouts(std::unique_ptr<ServiceTime> timeouts);
+
+    /**
+     * @brief Draws the timeout of one request.
+     *
+     * @return Cycles the request may wait after arrival, or 0 if no timeout distribution is set.
+     */
+    int next_timeout();
+
+    /**
+     * @brief Gets the Workload's random source.
+     *
+     * @return A reference to the Rng.
+     */
+    Rng& get_rng();
+
+    /**
+     * @brief Writes the random state and arrival process state to a binary snapshot.
+     *
+     * @param out Stream opened in binary mode.
+     */
+    void save(std::ostream& out) const;
+
+    /**
+     * @brief Restores state written by save().
+     *
+     * The Workload must have been built from the same specs as the one saved.
+     *
+     * @param in Stream opened in binary mode.
+     * @return True on success.
+     */
+    bool restore(std::istream& in);
+};
+
+#endif
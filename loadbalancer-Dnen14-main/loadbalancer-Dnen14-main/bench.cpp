@@ -0,0 +1,347 @@
+#include "HierarchicalBalancer.h"
+#include "LoadBalancer.h"
+#include "Metrics.h"
+#include "Request.h"
+#include "RequestQueue.h"
+#include "ShardedBalancer.h"
+#include "Tracing.h"
+#include "Workload.h"
+#include <benchmark/benchmark.h>
+#include <climits>
+#include <string>
+
+/**
+ * @file bench.cpp
+ * @brief Google Benchmark suite for the load balancer hot paths.
+ *
+ * Micro-benchmarks cover Request construction, RequestQueue::add_request and
+ * process_next_request, LoadBalancer::distribute_requests with single and batched
+ * dispatch, and adjust_servers.
+ * Macro-benchmarks run a complete seeded simulation at 1, 8, 64 and 1024 servers
+ * and report simulated requests completed per second of wall time, and a sharded
+ * tier is run at 1, 4 and 16 shards to show the cost of its message rounds. The
+ * routing cost of a global dispatcher is measured against its signal staleness bound.
+ * Metric updates are measured alone, from 1 to 8 threads, and inside distribute_requests().
+ * Tracing spans are measured disabled, sampled and fully recorded.
+ *
+ * Build and run with `make bench`, which writes the results to bench.json so runs
+ * of different versions can be compared (e.g. with Google Benchmark's compare.py).
+ * Logging and the simulated processing delay are disabled throughout so only the
+ * balancer itself is measured.
+ */
+
+/** Requests kept queued in the steady-state benchmarks. */
+static const int QUEUE_DEPTH = 4096;
+
+/** Cycles run by each end-to-end simulation. */
+static const int SIMULATION_CYCLES = 10000;
+
+/**
+ * @brief Builds a request like the ones main() generates.
+ *
+ * @param id Number used in the URL and body.
+ * @param taskTime Task time in cycles.
+ * @return Request The request.
+ */
+static Request make_request(int id, int taskTime) {
+    Request request;
+    request.set_method("GET");
+    request.set_url("/task" + std::to_string(id));
+    request.set_headers("Host: loadbalancer.com\nUser-Agent: C++-Client");
+    request.set_body("Request body " + std::to_string(id));
+    request.set_task_time(taskTime);
+    return request;
+}
+
+/**
+ * @brief Builds a silent LoadBalancer with a queue of single-cycle requests.
+ *
+ * @param servers Number of initial and maximum servers.
+ * @param depth Number of requests to queue.
+ * @return LoadBalancer* The LoadBalancer; owned by the caller.
+ */
+static LoadBalancer* make_balancer(int servers, int depth) {
+    LoadBalancer* lb = new LoadBalancer(servers, 8080, servers);
+    lb->set_verbose(false);
+    lb->set_max_processing_delay(0);
+    lb->seed(1);
+    for (int i = 0; i < depth; ++i) {
+        lb->add_request(make_request(i, 1));
+    }
+    return lb;
+}
+
+static void BM_Request_Construction(benchmark::State& state) {
+    int id = 0;
+    for (auto _ : state) {
+        Request request = make_request(id++, 3);
+        benchmark::DoNotOptimize(request);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Request_Construction);
+
+static void BM_RequestQueue_AddRequest(benchmark::State& state) {
+    Request request = make_request(0, 3);
+    RequestQueue* queue = new RequestQueue();
+    int queued = 0;
+    for (auto _ : state) {
+        queue->add_request(request);
+        if (++queued == QUEUE_DEPTH * 16) {
+            state.PauseTiming();
+            delete queue;
+            queue = new RequestQueue();
+            queued = 0;
+            state.ResumeTiming();
+        }
+    }
+    delete queue;
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RequestQueue_AddRequest);
+
+static void BM_RequestQueue_ProcessNextRequest(benchmark::State& state) {
+    Request request = make_request(0, 3);
+    RequestQueue queue;
+    queue.set_max_processing_delay(0);
+    for (auto _ : state) {
+        if (queue.is_empty()) {
+            state.PauseTiming();
+            for (int i = 0; i < QUEUE_DEPTH * 16; ++i) queue.add_request(request);
+            state.ResumeTiming();
+        }
+        queue.process_next_request();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RequestQueue_ProcessNextRequest);
+
+static void BM_LoadBalancer_DistributeRequests(benchmark::State& state) {
+    int servers = state.range(0);
+    LoadBalancer* lb = make_balancer(servers, QUEUE_DEPTH);
+    Request request = make_request(0, 1);
+    for (auto _ : state) {
+        lb->add_request(request);
+        lb->distribute_requests();
+    }
+    delete lb;
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoadBalancer_DistributeRequests)->Arg(1)->Arg(8)->Arg(64);
+
+/**
+ * @brief Dispatches a batch of the argument's size per distribute_requests() call.
+ *
+ * Runs 64 servers with 64 slots each so every batch finds room; items are
+ * requests dispatched, so the rate compares directly across batch sizes.
+ */
+static void BM_LoadBalancer_DistributeBatch(benchmark::State& state) {
+    int batch = state.range(0);
+    LoadBalancer* lb = new LoadBalancer(0, 8080, 64);
+    lb->set_verbose(false);
+    lb->set_max_processing_delay(0);
+    lb->seed(1);
+    InstanceType type;
+    type.slots = 64;
+    for (int i = 0; i < 64; ++i) lb->add_server(type);
+    lb->set_scaling_thresholds(INT_MAX, 0);
+    lb->set_dispatch_batch(batch);
+    Request request = make_request(0, 1);
+    for (auto _ : state) {
+        for (int i = 0; i < batch; ++i) lb->add_request(request);
+        lb->distribute_requests();
+    }
+    delete lb;
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_LoadBalancer_DistributeBatch)->Arg(1)->Arg(8)->Arg(64);
+
+static void BM_LoadBalancer_DistributeRequestsWithMetrics(benchmark::State& state) {
+    int servers = state.range(0);
+    MetricsRegistry registry;
+    LoadBalancer* lb = make_balancer(servers, QUEUE_DEPTH);
+    lb->enable_metrics(registry);
+    Request request = make_request(0, 1);
+    for (auto _ : state) {
+        lb->add_request(request);
+        lb->distribute_requests();
+    }
+    delete lb;
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoadBalancer_DistributeRequestsWithMetrics)->Arg(1)->Arg(8)->Arg(64);
+
+/**
+ * @brief Measures one TraceSpan with tracing off (-1) or on with a sample rate.
+ */
+static void BM_TraceSpan(benchmark::State& state) {
+    Tracer& tracer = Tracer::global();
+    if (state.range(0) > 0) tracer.enable(state.range(0));
+    for (auto _ : state) {
+        TraceSpan span("BM_TraceSpan");
+        benchmark::ClobberMemory();
+    }
+    tracer.disable();
+    tracer.clear();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TraceSpan)->Arg(-1)->Arg(1)->Arg(64);
+
+static void BM_Metrics_CounterInc(benchmark::State& state) {
+    static Counter counter;
+    for (auto _ : state) {
+        counter.inc();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Metrics_CounterInc)->ThreadRange(1, 8);
+
+static void BM_Metrics_HistogramObserve(benchmark::State& state) {
+    static Histogram histogram;
+    long long value = 0;
+    for (auto _ : state) {
+        histogram.observe(value++ & 1023);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Metrics_HistogramObserve)->ThreadRange(1, 8);
+
+/**
+ * @brief Measures one scaling decision with the queue held at a depth per server.
+ *
+ * With the default 5x/2x thresholds a depth of 3 measures the comparison alone,
+ * 6 takes the add_server() path and 1 the remove_server() path (the pool is idle,
+ * so the drained server is released at once). The change is undone outside the
+ * timing, so every iteration takes the same path.
+ */
+static void BM_LoadBalancer_AdjustServers(benchmark::State& state) {
+    int servers = state.range(0);
+    int depth = state.range(1);
+    LoadBalancer* lb = new LoadBalancer(servers, 8080, servers + 1);
+    lb->set_verbose(false);
+    lb->set_max_processing_delay(0);
+    lb->seed(1);
+    for (int i = 0; i < servers * depth; ++i) {
+        lb->add_request(make_request(i, 1));
+    }
+    for (auto _ : state) {
+        lb->adjust_servers();
+        if (depth == 3) continue;
+        state.PauseTiming();
+        if (depth > 3) {
+            lb->remove_server();
+        } else {
+            lb->add_server();
+        }
+        state.ResumeTiming();
+    }
+    delete lb;
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoadBalancer_AdjustServers)->ArgsProduct({{8, 64}, {1, 3, 6}});
+
+/**
+ * @brief Runs a full seeded simulation like main() and counts completed requests.
+ *
+ * Each run starts with servers * 100 queued requests and Poisson arrivals with
+ * uniform 1-5 cycle task times. Setup is excluded from the timing.
+ */
+static void BM_Simulation_EndToEnd(benchmark::State& state) {
+    int servers = state.range(0);
+    long long completed = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        LoadBalancer* lb = new LoadBalancer(0, 8080, servers);
+        lb->set_verbose(false);
+        lb->set_max_processing_delay(0);
+        lb->seed(42);
+        Workload workload(make_arrival_process("poisson:0.3"), make_service_time("uniform:1,5"), 42);
+        long long added = servers * 100;
+        for (int i = 0; i < added; ++i) {
+            lb->add_request(make_request(i, workload.next_task_time()));
+        }
+        state.ResumeTiming();
+
+        for (int cycle = 0; cycle < SIMULATION_CYCLES; ++cycle) {
+            int arrivals = workload.next_arrivals(cycle);
+            for (int n = 0; n < arrivals; ++n) {
+                lb->add_request(make_request(cycle, workload.next_task_time()));
+            }
+            added += arrivals;
+            lb->distribute_requests();
+        }
+
+        state.PauseTiming();
+        completed += lb->get_completed_requests();
+        delete lb;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(completed);
+    state.counters["cycles_per_second"] =
+        benchmark::Counter(state.iterations() * SIMULATION_CYCLES, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Simulation_EndToEnd)->Arg(1)->Arg(8)->Arg(64)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Runs a seeded ShardedBalancer tier with spillover and counts completed requests.
+ *
+ * Each shard may scale to 8 servers and receives Poisson arrivals at 0.3 per cycle,
+ * so per-cycle work stays constant per shard and the result shows the overhead of
+ * the message rounds as the tier grows. Every request gets its own URL, so URL-hash
+ * routing spreads the arrivals evenly over the shards.
+ */
+static void BM_ShardedBalancer_EndToEnd(benchmark::State& state) {
+    int shards = state.range(0);
+    long long completed = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        ShardedBalancer* tier = new ShardedBalancer(shards, 8, 16);
+        int requestId = 0;
+        tier->set_max_processing_delay(0);
+        tier->seed(42);
+        Workload workload(make_arrival_process("poisson:" + std::to_string(0.3 * shards)),
+                          make_service_time("uniform:1,5"), 42);
+        state.ResumeTiming();
+
+        for (int cycle = 0; cycle < SIMULATION_CYCLES; ++cycle) {
+            int arrivals = workload.next_arrivals(cycle);
+            for (int n = 0; n < arrivals; ++n) {
+                tier->add_request(make_request(requestId++, workload.next_task_time()));
+            }
+            tier->distribute_requests();
+        }
+
+        state.PauseTiming();
+        completed += tier->get_completed_requests();
+        delete tier;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(completed);
+    state.counters["cycles_per_second"] =
+        benchmark::Counter(state.iterations() * SIMULATION_CYCLES, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_ShardedBalancer_EndToEnd)->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+ * @brief Measures one routing decision of a 16-rack HierarchicalBalancer.
+ *
+ * The argument is the staleness bound; 0 pulls every rack's signal per decision,
+ * which is the coordination overhead that staler signals avoid.
+ */
+static void BM_HierarchicalBalancer_Route(benchmark::State& state) {
+    HierarchicalBalancer hierarchy(16, 8, state.range(0));
+    Request request = make_request(0, 1);
+    int routed = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(hierarchy.route(request));
+        if (++routed == 4) {
+            hierarchy.distribute_requests();
+            routed = 0;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["signal_updates"] = benchmark::Counter(hierarchy.get_signal_updates(), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_HierarchicalBalancer_Route)->Arg(0)->Arg(10)->Arg(1000);
+
+BENCHMARK_MAIN();
@@ -2,6 +2,14 @@
 #include "LoadBalancer.h"
 #include "Request.h"
 #include "RequestQueue.h"
+#include "Workload.h"
+#include "TraceReader.h"
+#include "TraceReplayer.h"
+#include "Snapshot.h"
+#include "Metrics.h"
+#include "MetricsExporter.h"
+#include "Tracing.h"
+#include <cmath>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
@@ -25,6 +33,71 @@
  * The main function handles user input, initializes the LoadBalancer instance, 
  * populates the request queue, and generates requests while displaying status updates.
  * 
+ * Traffic is drawn from a Workload; the arrival process and service time distribution
+ * can be chosen on the command line:
+ * 
+ *     ./myprogram [--arrivals SPEC] [--service SPEC] [--seed N]
+ * 
+ * e.g. --arrivals poisson:0.05 --service pareto:1,1.5. The defaults reproduce the
+ * original generator: a 5% chance of one arrival per cycle and uniform task times.
+ * 
+ * Alternatively a recorded access log can be replayed instead of generated traffic:
+ * 
+ *     ./myprogram --trace access.log [--trace-scale CYCLES_PER_SECOND] [--trace-speedup X]
+ * 
+ * In that case the initial queue is left empty and the cycle count entered at the
+ * prompt is an upper bound (0 replays the whole trace).
+ * 
+ * Every random source is derived from --seed, so two runs with the same seed and
+ * options produce identical logs. The seed is logged so any run can be repeated.
+ * Synthetic runs can also be checkpointed and resumed:
+ * 
+ *     ./myprogram --seed 42 --checkpoint sim.snap --checkpoint-at 5000
+ *     ./myprogram --seed 42 --restore sim.snap
+ * 
+ * The resumed run must use the same --arrivals and --service specs.
+ * 
+ * Metrics can be watched while the simulation runs, either scraped over HTTP or
+ * read from a file rewritten every --metrics-interval milliseconds (default 1000):
+ * 
+ *     ./myprogram --metrics-port 9100      (then: curl localhost:9100/metrics)
+ *     ./myprogram --metrics-file metrics.prom [--metrics-interval MS]
+ * 
+ * The hot paths can be profiled without an external profiler by recording tracing
+ * spans for one cycle in --trace-sample (default 1) and opening the resulting file
+ * in chrome://tracing or Perfetto:
+ * 
+ *     ./myprogram --chrome-trace trace.json [--trace-sample N]
+ * 
+ * Clients can be made to give up on slow requests: with --timeout CYCLES each
+ * request expires that many cycles after arrival and is dropped from the queue, or
+ * cancelled if a server had already started it. --timeout also accepts a
+ * distribution spec such as uniform:10,60 or exp:30, drawing each synthetic
+ * request's timeout so that deadlines differ between requests; --queue-order edf
+ * then serves the earliest deadline first instead of the oldest request:
+ * 
+ *     ./myprogram --timeout uniform:10,60 --queue-order edf
+ * 
+ * A mixed fleet is simulated by giving each server an instance type; servers are
+ * provisioned from the listed types in turn, and --dispatch fastest sends each
+ * request to the server expected to finish it first:
+ * 
+ *     ./myprogram --instance-type old:1,1 --instance-type new:2,4 [--dispatch round-robin|fastest]
+ * 
+ * Servers removed on scale-down drain first: they take no new requests and are
+ * released once their in-flight requests finish, or after --drain-timeout CYCLES
+ * when what is left is handed back to the queue. The end status compares the p99
+ * latency of requests caught by a scale-down with the overall p99.
+ * 
+ * By default one queued request is started per cycle; --batch N starts up to N,
+ * taken from the queue together and assigned in one pass.
+ * 
+ * --cache-ttl CYCLES answers repeated GET requests from an in-balancer response
+ * cache for that long, within --cache-memory BYTES (default 64 MiB). Synthetic
+ * requests have unique URLs, so this mostly pays off when replaying a --trace:
+ * 
+ *     ./myprogram --trace access.log --cache-ttl 1000 [--cache-memory BYTES]
+ * 
  */
 
 using std::cout, std::endl, std::cin, std::string, std::to_string, std::ofstream, std::cerr, std::streambuf;
@@ -39,6 +112,48 @@ using std::cout, std::endl, std::cin, std::string, std::to_string, std::ofstream
     int initialQueueSize;
     /** Minimum time for a task to be processed (in milliseconds). */
     int minTaskTime = 1;
+    /** Arrival process spec passed to make_arrival_process(). */
+    string arrivalSpec = "bernoulli:0.05";
+    /** Service time spec passed to make_service_time(); defaults to uniform over the task range. */
+    string serviceSpec;
+    /** Access log to replay instead of generating traffic; empty for synthetic traffic. */
+    string tracePath;
+    /** Simulation cycles per second of recorded trace time. */
+    double traceScale = 1000.0;
+    /** Factor by which gaps between recorded arrivals are compressed. */
+    double traceSpeedup = 1.0;
+    /** Snapshot file written at checkpointCycle; empty to disable checkpointing. */
+    string checkpointPath;
+    /** Cycle at which the checkpoint is written. */
+    int checkpointCycle = -1;
+    /** Snapshot file to resume from; empty to start a fresh run. */
+    string restorePath;
+    /** Local port serving metrics over HTTP; 0 to disable. */
+    int metricsPort = 0;
+    /** File rewritten with the current metrics; empty to disable. */
+    string metricsPath;
+    /** Milliseconds between rewrites of metricsPath. */
+    int metricsInterval = 1000;
+    /** Chrome trace file written at the end of the run; empty to disable tracing. */
+    string chromeTracePath;
+    /** One cycle in this many is traced. */
+    int traceSample = 1;
+    /** Timeout spec passed to parse_timeout(): cycles a request may wait before it expires, or a distribution. */
+    string timeoutSpec = "0";
+    /** Order in which queued requests are served. */
+    QueueOrder queueOrder = QueueOrder::FIFO;
+    /** Instance types servers are provisioned from; empty for standard servers. */
+    std::vector<InstanceType> instanceTypes;
+    /** How servers are picked for each request. */
+    DispatchPolicy dispatchPolicy = DispatchPolicy::ROUND_ROBIN;
+    /** Cycles a draining server may keep serving; negative to wait for every request. */
+    int drainTimeout = -1;
+    /** Largest number of queued requests started per cycle. */
+    int dispatchBatch = 1;
+    /** Cycles a cached GET response stays valid; 0 to disable the response cache. */
+    int cacheTtl = 0;
+    /** Bytes the response cache may hold. */
+    long long cacheMemory = 64LL << 20;
 
 /**
  * @brief Prints the starting size of the request queue.
@@ -50,16 +165,27 @@ void printStartingQueue(){
 /**
  * @brief Generates requests randomly and adds them to the LoadBalancer.
  *
- * This function runs for a specified number of cycles, generating new requests
- * based on random conditions, adding them to the LoadBalancer, and distributing
- * requests to the servers. It also sleeps for a random amount of time between
- * task processing.
+ * This function runs until the LoadBalancer reaches the requested number of cycles,
+ * drawing the number of new requests and their task times from the workload, adding
+ * them to the LoadBalancer, and distributing requests to the servers. A restored
+ * LoadBalancer picks up at the cycle it was saved at. If a checkpoint is configured
+ * it is written at the start of that cycle.
  *
  * @param lb Reference to the LoadBalancer instance.
+ * @param workload The traffic generator.
  */
-void randomAddRequest(LoadBalancer &lb){
-    for (int cycle = 0; cycle < totalCycles; ++cycle) {
-        if (rand() < 107374182) {
+void randomAddRequest(LoadBalancer &lb, Workload &workload){
+    for (int cycle = lb.get_cycle(); cycle < totalCycles; ++cycle) {
+        if (cycle == checkpointCycle) {
+            if (save_snapshot(checkpointPath, lb, workload)) {
+                cout << "[LOG] Checkpoint written to " << checkpointPath << " at cycle " << cycle << endl;
+            } else {
+                cerr << "Error writing checkpoint " << checkpointPath << endl;
+            }
+        }
+
+        int arrivals = workload.next_arrivals(cycle);
+        for (int n = 0; n < arrivals; ++n) {
             Request newReq;
             newReq.set_method("POST");
             newReq.set_url("/newtask" + to_string(cycle));
@@ -68,8 +194,10 @@ void randomAddRequest(LoadBalancer &lb){
             //lb.add_request(newReq);
            //cout << "[LOG] New request generated at cycle " << cycle << endl;
 
-           int randomTaskTime = rand() % maxTaskTime + minTaskTime;
+           int randomTaskTime = workload.next_task_time();
            newReq.set_task_time(randomTaskTime);
+           int timeout = workload.next_timeout();
+           if (timeout > 0) newReq.set_deadline(cycle + timeout);
 
             lb.add_request(newReq);
             cout << "[LOG] New request generated at cycle " << cycle 
@@ -93,14 +221,34 @@ void printEndingQueue(LoadBalancer &lb){
     cout << "[END STATUS] Active servers: " << lb.get_active_server_count() << endl;
     cout << "[END STATUS] In-active servers: " <<  numServers - lb.get_active_server_count() << endl;
     lb.print_remaining_requests();
+    if (lb.get_in_flight_requests() > 0) {
+        cout << "[END STATUS] Requests still in flight: " << lb.get_in_flight_requests() << endl;
+    }
+    cout << "[END STATUS] Server cost: " << lb.get_server_cost() << " (" << lb.get_server_cycles() << " server cycles)" << endl;
+    if (lb.get_drained_servers() > 0) {
+        cout << "[END STATUS] Servers drained: " << lb.get_drained_servers() << " (" << lb.get_handed_off_requests()
+             << " requests handed off)" << endl;
+        cout << "[END STATUS] p99 latency: " << lb.get_latency_histogram().percentile(99.0) << " cycles overall, "
+             << lb.get_drain_latency_histogram().percentile(99.0) << " when caught by a scale-down" << endl;
+    }
+    if (lb.get_expired_requests() > 0 || lb.get_cancelled_requests() > 0) {
+        cout << "[END STATUS] Expired requests: " << lb.get_expired_requests() << endl;
+        cout << "[END STATUS] Cancelled requests: " << lb.get_cancelled_requests()
+             << " (" << lb.get_wasted_cycles() << " server cycles wasted)" << endl;
+    }
+    if (lb.get_cache()) {
+        cout << "[END STATUS] Cache hits: " << lb.get_cache()->get_hits() << " (" << lb.get_cache()->get_misses()
+             << " misses, " << lb.get_cache()->get_bytes() << " bytes cached)" << endl;
+    }
 
 }
 
 /**
- * @brief Prints the range of task processing times.
+ * @brief Prints the workload the simulation was run with.
  */
 void printTaskRange(){
-    cout << "Task time range: " << minTaskTime << " to " << maxTaskTime << " clock cycles" << endl;
+    cout << "Arrival process: " << arrivalSpec << endl;
+    cout << "Task time distribution: " << serviceSpec << " (clock cycles)" << endl;
 }
 
 /**
@@ -111,10 +259,115 @@ void printTaskRange(){
  * initializes the LoadBalancer, populates the request queue, and starts generating
  * requests. Finally, it prints the ending status of the LoadBalancer.
  * 
+ * @param argc Number of command line arguments.
+ * @param argv Command line arguments (see the file description for options).
  * @return 0 on successful execution.
  */
-int main(void) {
-    srand(static_cast<unsigned int>(time(nullptr)));
+int main(int argc, char* argv[]) {
+    unsigned long long seed = static_cast<unsigned long long>(time(nullptr));
+    serviceSpec = "uniform:" + to_string(minTaskTime) + "," + to_string(maxTaskTime);
+    for (int i = 1; i < argc; i += 2) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for option " << option << endl;
+            return 1;
+        } else if (option == "--arrivals") {
+            arrivalSpec = argv[i + 1];
+        } else if (option == "--service") {
+            serviceSpec = argv[i + 1];
+        } else if (option == "--seed") {
+            seed = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (option == "--trace") {
+            tracePath = argv[i + 1];
+        } else if (option == "--trace-scale") {
+            traceScale = std::strtod(argv[i + 1], nullptr);
+        } else if (option == "--trace-speedup") {
+            traceSpeedup = std::strtod(argv[i + 1], nullptr);
+        } else if (option == "--checkpoint") {
+            checkpointPath = argv[i + 1];
+        } else if (option == "--checkpoint-at") {
+            checkpointCycle = std::atoi(argv[i + 1]);
+        } else if (option == "--restore") {
+            restorePath = argv[i + 1];
+        } else if (option == "--metrics-port") {
+            metricsPort = std::atoi(argv[i + 1]);
+        } else if (option == "--metrics-file") {
+            metricsPath = argv[i + 1];
+        } else if (option == "--metrics-interval") {
+            metricsInterval = std::atoi(argv[i + 1]);
+        } else if (option == "--chrome-trace") {
+            chromeTracePath = argv[i + 1];
+        } else if (option == "--trace-sample") {
+            traceSample = std::atoi(argv[i + 1]);
+        } else if (option == "--timeout") {
+            timeoutSpec = argv[i + 1];
+        } else if (option == "--queue-order") {
+            string order = argv[i + 1];
+            if (order != "fifo" && order != "edf") {
+                cerr << "Unknown queue order " << order << endl;
+                return 1;
+            }
+            queueOrder = order == "edf" ? QueueOrder::EDF : QueueOrder::FIFO;
+        } else if (option == "--instance-type") {
+            InstanceType type;
+            if (!parse_instance_type(argv[i + 1], type)) {
+                cerr << "Invalid instance type " << argv[i + 1] << endl;
+                return 1;
+            }
+            instanceTypes.push_back(type);
+        } else if (option == "--cache-ttl") {
+            cacheTtl = std::atoi(argv[i + 1]);
+        } else if (option == "--cache-memory") {
+            cacheMemory = std::atoll(argv[i + 1]);
+        } else if (option == "--batch") {
+            dispatchBatch = std::atoi(argv[i + 1]);
+        } else if (option == "--drain-timeout") {
+            drainTimeout = std::atoi(argv[i + 1]);
+        } else if (option == "--dispatch") {
+            string policy = argv[i + 1];
+            if (policy != "round-robin" && policy != "fastest") {
+                cerr << "Unknown dispatch policy " << policy << endl;
+                return 1;
+            }
+            dispatchPolicy = policy == "fastest" ? DispatchPolicy::FASTEST_COMPLETION : DispatchPolicy::ROUND_ROBIN;
+        } else {
+            cerr << "Unknown option " << option << endl;
+            return 1;
+        }
+    }
+
+    std::unique_ptr<ArrivalProcess> arrivalProcess = make_arrival_process(arrivalSpec);
+    std::unique_ptr<ServiceTime> serviceTime = make_service_time(serviceSpec);
+    if (!arrivalProcess || !serviceTime) {
+        cerr << "Invalid workload spec: " << arrivalSpec << " / " << serviceSpec << endl;
+        return 1;
+    }
+    if (!std::isfinite(traceScale) || traceScale <= 0.0 || !std::isfinite(traceSpeedup) || traceSpeedup <= 0.0) {
+        cerr << "--trace-scale and --trace-speedup must be positive" << endl;
+        return 1;
+    }
+    if (!tracePath.empty() && (!checkpointPath.empty() || !restorePath.empty())) {
+        cerr << "Checkpointing is only supported for synthetic workloads" << endl;
+        return 1;
+    }
+    int requestTimeout = 0;
+    std::unique_ptr<ServiceTime> timeouts;
+    if (!parse_timeout(timeoutSpec, requestTimeout, timeouts)) {
+        cerr << "Invalid timeout " << timeoutSpec << endl;
+        return 1;
+    }
+    if (timeouts && !tracePath.empty()) {
+        cerr << "Timeout distributions are only supported for synthetic workloads" << endl;
+        return 1;
+    }
+    Workload workload(std::move(arrivalProcess), std::move(serviceTime), derive_seed(seed, 0));
+    workload.set_timeouts(std::move(timeouts));
+
+    TraceReader trace;
+    if (!tracePath.empty() && !trace.open(tracePath)) {
+        cerr << "Error opening trace " << tracePath << endl;
+        return 1;
+    }
 
     cout << "Enter in the number of servers and the total cyles you want to run the load balancer in this format (serverSize time) not including the paratheses" << endl;
     cin >> numServers >> totalCycles;
@@ -123,7 +376,7 @@ int main(void) {
         cout << "Please enter a valid input" << endl;
         return 0;
     }
-    initialQueueSize = numServers * 100;
+    initialQueueSize = tracePath.empty() ? numServers * 100 : 0;
     
     ofstream outFile("Log.txt");
 
@@ -136,22 +389,74 @@ int main(void) {
     cout.rdbuf(outFile.rdbuf());
 
     LoadBalancer lb(0, 8080, numServers);
+    lb.enable_health_checks(true);
+    lb.seed(seed);
+    lb.set_request_timeout(requestTimeout);
+    lb.set_queue_order(queueOrder);
+    lb.set_instance_types(instanceTypes);
+    lb.set_dispatch_policy(dispatchPolicy);
+    lb.set_drain_timeout(drainTimeout);
+    lb.set_dispatch_batch(dispatchBatch);
+    if (cacheTtl > 0 && cacheMemory > 0) lb.enable_cache(16, cacheMemory, cacheTtl);
+    cout << "[LOG] Seed: " << seed << endl;
+
+    MetricsRegistry registry;
+    MetricsExporter httpExporter(registry);
+    MetricsExporter fileExporter(registry);
+    if (metricsPort > 0 || !metricsPath.empty()) lb.enable_metrics(registry);
+    if ((metricsPort > 0 && !httpExporter.serve_http(metricsPort))
+        || (!metricsPath.empty() && !fileExporter.write_periodically(metricsPath, metricsInterval))) {
+        cout.rdbuf(originalCoutBuffer);
+        cerr << "Error starting metrics exporter" << endl;
+        return 1;
+    }
+
+    if (!restorePath.empty()) {
+        if (!load_snapshot(restorePath, lb, workload)) {
+            cout.rdbuf(originalCoutBuffer);
+            cerr << "Error restoring snapshot " << restorePath << endl;
+            return 1;
+        }
+        cout << "[LOG] Restored " << restorePath << " at cycle " << lb.get_cycle() << endl;
+        initialQueueSize = 0;
+    }
 
     for (int i = 0; i < initialQueueSize; ++i) {
-        int randomTaskTime = rand() % maxTaskTime + minTaskTime;
+        int randomTaskTime = workload.next_task_time();
         Request req;
         req.set_method("GET");
         req.set_url("/task" + to_string(i));
         req.set_headers("Host: loadbalancer.com\nUser-Agent: C++-Client");
         req.set_body("Request body " + to_string(i));
         req.set_task_time(randomTaskTime);
+        int timeout = workload.next_timeout();
+        if (timeout > 0) req.set_deadline(lb.get_cycle() + timeout);
         lb.add_request(req);
     }
 
+    if (!chromeTracePath.empty()) Tracer::global().enable(traceSample);
     printStartingQueue();
-    randomAddRequest(lb);
+    if (tracePath.empty()) {
+        randomAddRequest(lb, workload);
+    } else {
+        TraceReplayer replayer(lb, trace, traceScale, traceSpeedup);
+        replayer.run(totalCycles);
+        cout << "[LOG] Replayed " << replayer.get_replayed() << " requests from " << tracePath
+             << " (" << trace.get_skipped_lines() << " malformed lines skipped)" << endl;
+    }
+    if (!chromeTracePath.empty()) {
+        Tracer::global().disable();
+        if (Tracer::global().write_chrome_trace(chromeTracePath)) {
+            cout << "[LOG] Wrote " << Tracer::global().get_event_count() << " spans to " << chromeTracePath
+                 << " (" << Tracer::global().get_dropped() << " dropped)" << endl;
+        } else {
+            cerr << "Error writing trace " << chromeTracePath << endl;
+        }
+    }
+    httpExporter.stop();
+    fileExporter.stop();
     printEndingQueue(lb);
-    printTaskRange();
+    if (tracePath.empty()) printTaskRange();
 
     outFile.close();
     cout.rdbuf(originalCoutBuffer);
@@ -0,0 +1,270 @@
+#include "Sweep.h"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+/**
+ * @file sweep_main.cpp
+ * @brief Command-line driver for capacity-planning sweeps.
+ *
+ * Runs every combination of the given grid for a number of seeds on a pool of
+ * threads and prints one CSV row per grid point with 95% confidence intervals:
+ *
+ *     ./sweep --servers 1,2,4,8 --policies round-robin,sticky \
+ *             --arrivals poisson:0.2 --arrivals mmpp:0.1,0.8,0.01,0.05 \
+ *             --service uniform:1,5 --thresholds 5:2,10:4 \
+ *             --seeds 20 --cycles 20000 --threads 0 --base-seed 7
+ *
+ * Multi-node tiers are swept with --shards 1,4,8 and --spill-threshold N, in
+ * which case --servers is the maximum per shard. A global dispatcher over rack
+ * balancers is swept with --racks 4 --staleness 0,1,10,100; the signal_updates
+ * column counts the load signals it pulled, against which p99_latency shows what
+ * staler signals cost. Points with more than one shard and more than one rack are
+ * skipped with a message on stderr.
+ *
+ * Mixed hardware is swept with --fleet, a '+'-separated list of instance types
+ * (name:speed,slots[,memory[,cost]]) that servers are provisioned from in turn:
+ *
+ *     ./sweep --servers 2,4,8,16 --fleet small:1,1 --fleet large:4,4
+ *     ./sweep --fleet old:1,1+new:3,1 --policies round-robin,fastest
+ *
+ * The server_cost column prices each run, so many small instances can be weighed
+ * against fewer large ones at equal p99_latency.
+ *
+ * Scale-down is tuned with --thresholds and --drain-timeouts -1,0,20 (cycles a
+ * draining server may keep serving before handing its requests back; -1 waits
+ * for them to finish). The drain_p99_latency column is the p99 of requests that
+ * were in flight on a server when it started draining (0 if none were), to
+ * compare against p99_latency.
+ *
+ * --batches 1,8,64 lets each balancer start up to that many queued requests per
+ * cycle instead of one.
+ *
+ * --timeouts 0,50,200 gives requests a deadline that many cycles after arrival;
+ * the expired column counts those dropped or cancelled once it passed. --timeout
+ * SPEC instead draws each request's timeout from a service-time style
+ * distribution, so deadlines differ between requests; compare
+ * --policies round-robin,edf to see what serving the earliest deadline first buys:
+ *
+ *     ./sweep --timeout uniform:5,60 --policies round-robin,edf --arrivals poisson:0.9
+ *
+ * --policies round-robin,cache puts a response cache in front of the servers; the
+ * cache_hits column counts requests it answered, which never reach a server and
+ * so are not in throughput or p99_latency.
+ *
+ * --arrivals, --service, --fleet and --timeout may be repeated; list options are
+ * comma-separated.
+ * --threads 0 (the default) uses every hardware thread. Counts must be whole
+ * numbers: at least 1 for --shards, --racks, --servers, --batches, --seeds and
+ * --cycles, and at least 0 for --staleness and --threads.
+ */
+
+/**
+ * @brief Splits a comma-separated list.
+ *
+ * @param text The list.
+ * @return std::vector<string> The non-empty fields.
+ */
+static std::vector<string> split(const string& text) {
+    std::vector<string> fields;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == string::npos) end = text.size();
+        if (end > start) fields.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return fields;
+}
+
+/**
+ * @brief Parses a whole number with a lower bound.
+ *
+ * @param text The number.
+ * @param minimum Smallest accepted value.
+ * @param value Set to the parsed number.
+ * @return true If text is a whole number in [minimum, INT_MAX].
+ */
+static bool parse_count(const string& text, int minimum, int& value) {
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno != 0 || parsed < minimum || parsed > INT_MAX) return false;
+    value = (int) parsed;
+    return true;
+}
+
+/**
+ * @brief Parses a comma-separated list of whole numbers with a lower bound, such as "1,4,8".
+ *
+ * @param text The list.
+ * @param minimum Smallest accepted value.
+ * @param values Set to the parsed numbers.
+ * @return true If the list is non-empty and every number parsed.
+ */
+static bool parse_counts(const string& text, int minimum, std::vector<int>& values) {
+    values.clear();
+    for (const string& field : split(text)) {
+        int value = 0;
+        if (!parse_count(field, minimum, value)) return false;
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+/**
+ * @brief Parses a list of scaling thresholds such as "5:2,10:4".
+ *
+ * @param text The list.
+ * @param thresholds Set to the parsed (scale-up, scale-down) pairs.
+ * @return true If every pair parsed.
+ */
+static bool parse_thresholds(const string& text, std::vector<std::pair<int, int>>& thresholds) {
+    thresholds.clear();
+    for (const string& field : split(text)) {
+        size_t colon = field.find(':');
+        if (colon == string::npos) return false;
+        int up = std::atoi(field.substr(0, colon).c_str());
+        int down = std::atoi(field.substr(colon + 1).c_str());
+        if (up <= 0 || down < 0) return false;
+        thresholds.push_back({up, down});
+    }
+    return !thresholds.empty();
+}
+
+/**
+ * @brief Prints an estimate as two CSV columns, mean and half-width.
+ */
+static void print_estimate(const Estimate& value) {
+    cout << "," << value.mean << "," << value.halfWidth;
+}
+
+/**
+ * @brief Parses the grid, runs the sweep and prints the results as CSV.
+ *
+ * @param argc Number of command line arguments.
+ * @param argv Command line arguments (see the file description for options).
+ * @return 0 on success, 1 on invalid arguments.
+ */
+int main(int argc, char* argv[]) {
+    SweepGrid grid;
+    std::vector<string> arrivals;
+    std::vector<string> services;
+    std::vector<string> fleets;
+    std::vector<string> timeouts;
+    int threads = 0;
+    for (int i = 1; i < argc; i += 2) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for option " << option << endl;
+            return 1;
+        }
+        string value = argv[i + 1];
+        if (option == "--shards") {
+            if (!parse_counts(value, 1, grid.shards)) {
+                cerr << "Invalid shard counts " << value << endl;
+                return 1;
+            }
+        } else if (option == "--spill-threshold") {
+            grid.spillThreshold = std::atoi(value.c_str());
+        } else if (option == "--racks") {
+            if (!parse_counts(value, 1, grid.racks)) {
+                cerr << "Invalid rack counts " << value << endl;
+                return 1;
+            }
+        } else if (option == "--staleness") {
+            if (!parse_counts(value, 0, grid.staleness)) {
+                cerr << "Invalid staleness " << value << endl;
+                return 1;
+            }
+        } else if (option == "--servers") {
+            if (!parse_counts(value, 1, grid.servers)) {
+                cerr << "Invalid server counts " << value << endl;
+                return 1;
+            }
+        } else if (option == "--policies") {
+            grid.policies = split(value);
+        } else if (option == "--arrivals") {
+            arrivals.push_back(value);
+        } else if (option == "--service") {
+            services.push_back(value);
+        } else if (option == "--fleet") {
+            std::vector<InstanceType> types;
+            if (!parse_fleet(value, types)) {
+                cerr << "Invalid fleet " << value << endl;
+                return 1;
+            }
+            fleets.push_back(value);
+        } else if (option == "--thresholds") {
+            if (!parse_thresholds(value, grid.thresholds)) {
+                cerr << "Invalid thresholds " << value << endl;
+                return 1;
+            }
+        } else if (option == "--timeouts") {
+            for (const string& field : split(value)) timeouts.push_back(field);
+        } else if (option == "--timeout") {
+            timeouts.push_back(value);
+        } else if (option == "--drain-timeouts") {
+            grid.drainTimeouts.clear();
+            for (const string& field : split(value)) grid.drainTimeouts.push_back(std::atoi(field.c_str()));
+        } else if (option == "--batches") {
+            if (!parse_counts(value, 1, grid.batches)) {
+                cerr << "Invalid batch sizes " << value << endl;
+                return 1;
+            }
+        } else if (option == "--seeds") {
+            if (!parse_count(value, 1, grid.seeds)) {
+                cerr << "Invalid seed count " << value << endl;
+                return 1;
+            }
+        } else if (option == "--cycles") {
+            if (!parse_count(value, 1, grid.cycles)) {
+                cerr << "Invalid cycle count " << value << endl;
+                return 1;
+            }
+        } else if (option == "--threads") {
+            if (!parse_count(value, 0, threads)) {
+                cerr << "Invalid thread count " << value << endl;
+                return 1;
+            }
+        } else if (option == "--base-seed") {
+            grid.baseSeed = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            cerr << "Unknown option " << option << endl;
+            return 1;
+        }
+    }
+    if (!arrivals.empty()) grid.arrivals = arrivals;
+    if (!services.empty()) grid.services = services;
+    if (!fleets.empty()) grid.fleets = fleets;
+    if (!timeouts.empty()) grid.timeouts = timeouts;
+
+    std::vector<SweepPoint> points = SweepRunner(threads).run(grid);
+
+    cout << "shards,racks,staleness,servers,fleet,policy,arrivals,service,scale_up,scale_down,timeout,drain_timeout,batch,runs,"
+         << "throughput,throughput_ci,p99_latency,p99_latency_ci,drain_p99_latency,drain_p99_latency_ci,server_cycles,server_cycles_ci,server_cost,server_cost_ci,signal_updates,signal_updates_ci,expired,expired_ci,cache_hits,cache_hits_ci" << endl;
+    cout << std::setprecision(6);
+    for (const SweepPoint& point : points) {
+        const SimulationConfig& config = point.config;
+        cout << config.shards << "," << config.racks << "," << config.staleness << "," << config.servers << ",\"" << config.fleet << "\"," << config.policy << ",\"" << config.arrivals << "\",\""
+             << config.service << "\"," << config.scaleUp << "," << config.scaleDown << ",\"" << config.timeout << "\"," << config.drainTimeout << "," << config.batch << "," << point.runs;
+        print_estimate(point.throughput);
+        print_estimate(point.p99Latency);
+        print_estimate(point.drainP99Latency);
+        print_estimate(point.serverCycles);
+        print_estimate(point.serverCost);
+        print_estimate(point.signalUpdates);
+        print_estimate(point.expired);
+        print_estimate(point.cacheHits);
+        cout << endl;
+    }
+    return 0;
+}
@@ -1 +1,81 @@
-#include "utils.h"
\ No newline at end of file
+/**
+ * @file utils.cpp
+ * @brief Implementation of the shared helper functions.
+ */
+
+#include "utils.h"
+
+/**
+ * @brief Hashes a string with 64-bit FNV-1a.
+ *
+ * @param value The string to hash.
+ * @return uint64_t The 64-bit hash.
+ */
+uint64_t fnv1a_hash(const std::string& value) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : value) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Maps a key to a bucket with jump consistent hashing (Lamping and Veach).
+ *
+ * @param key The key to map.
+ * @param buckets Number of buckets; must be positive.
+ * @return int Bucket index in [0, buckets).
+ */
+int jump_consistent_hash(uint64_t key, int buckets) {
+    int64_t b = -1;
+    int64_t j = 0;
+    while (j < buckets) {
+        b = j;
+        key = key * 2862933555777941757ULL + 1;
+        j = (int64_t) ((b + 1) * (double(1LL << 31) / double((key >> 33) + 1)));
+    }
+    return (int) b;
+}
+
+/**
+ * @brief Writes a length-prefixed string to a binary snapshot stream.
+ *
+ * @param out Stream opened in binary mode.
+ * @param value The string to write.
+ */
+void write_string(std::ostream& out, const std::string& value) {
+    write_value<uint32_t>(out, value.size());
+    out.write(value.data(), value.size());
+}
+
+/**
+ * @brief Checks that a snapshot stream still holds at least a number of bytes.
+ *
+ * @param in Seekable stream opened in binary mode.
+ * @param bytes Number of bytes the caller is about to read.
+ * @return bool True if that many bytes remain.
+ */
+bool stream_has(std::istream& in, uint64_t bytes) {
+    std::streampos here = in.tellg();
+    if (here == std::streampos(-1)) return false;
+    in.seekg(0, std::ios::end);
+    std::streampos end = in.tellg();
+    in.seekg(here);
+    return end != std::streampos(-1) && end >= here && (uint64_t) (end - here) >= bytes;
+}
+
+/**
+ * @brief Reads a string written by write_string().
+ *
+ * @param in Stream opened in binary mode.
+ * @param value Set to the string read.
+ * @return true If the string was read completely.
+ */
+bool read_string(std::istream& in, std::string& value) {
+    uint32_t size = 0;
+    if (!read_value(in, size) || !stream_has(in, size)) return false;
+    value.resize(size);
+    in.read(&value[0], size);
+    return (bool) in;
+}
@@ -1,5 +1,92 @@
 #ifndef UTILS_H
 #define UTILS_H
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
 
+/**
+ * @file utils.h
+ * @brief Small helpers shared by the load balancer modules.
+ */
 
-#endif
\ No newline at end of file
+/**
+ * @brief Hashes a string with 64-bit FNV-1a.
+ *
+ * Unlike std::hash, the result is the same on every platform and run, so anything
+ * routed by it (cache shards, sticky sessions) is reproducible.
+ *
+ * @param value The string to hash.
+ * @return The 64-bit hash.
+ */
+uint64_t fnv1a_hash(const std::string& value);
+
+/**
+ * @brief Maps a key to one of a number of buckets with jump consistent hashing.
+ *
+ * When the bucket count grows or shrinks by one, only about 1/buckets of the keys
+ * move, which keeps sticky sessions in place while the server pool is resized.
+ *
+ * @param key The key to map.
+ * @param buckets Number of buckets; must be positive.
+ * @return Bucket index in [0, buckets).
+ */
+int jump_consistent_hash(uint64_t key, int buckets);
+
+/**
+ * @brief Writes a trivially copyable value to a binary snapshot stream.
+ *
+ * Values are written in host byte order; snapshots are meant to be restored on the
+ * same kind of machine that wrote them.
+ *
+ * @param out Stream opened in binary mode.
+ * @param value The value to write.
+ */
+template <typename T>
+void write_value(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * @brief Reads a value written by write_value().
+ *
+ * @param in Stream opened in binary mode.
+ * @param value Set to the value read.
+ * @return True if the value was read completely.
+ */
+template <typename T>
+bool read_value(std::istream& in, T& value) {
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return (bool) in;
+}
+
+/**
+ * @brief Writes a length-prefixed string to a binary snapshot stream.
+ *
+ * @param out Stream opened in binary mode.
+ * @param value The string to write.
+ */
+void write_string(std::ostream& out, const std::string& value);
+
+/**
+ * @brief Checks that a snapshot stream still holds at least a number of bytes.
+ *
+ * Used before allocating room for a count read from a snapshot, so a corrupt or
+ * truncated file fails to restore instead of requesting a huge allocation.
+ *
+ * @param in Seekable stream opened in binary mode.
+ * @param bytes Number of bytes the caller is about to read.
+ * @return True if that many bytes remain; false if not or if the stream cannot seek.
+ */
+bool stream_has(std::istream& in, uint64_t bytes);
+
+/**
+ * @brief Reads a string written by write_string().
+ *
+ * @param in Stream opened in binary mode.
+ * @param value Set to the string read.
+ * @return True if the string was read completely.
+ */
+bool read_string(std::istream& in, std::string& value);
+
+#endif